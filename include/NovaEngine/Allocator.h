@@ -2,6 +2,7 @@
 #include <VulkanWrapper/VulkanWrapper.h>
 #include "NovaEngine/RawAllocator.h"
 #include "NovaEngine/IResourceAllocator.h"
+#include <boost/signals2.hpp>
 
 namespace Nova {
     class Engine;
@@ -24,6 +25,9 @@ namespace Nova {
         RawAllocator<T, TCreateInfo> m_allocator;
         std::unordered_map<RawResource<T>*, std::unique_ptr<RawResource<T>>> m_resources;
         std::vector<std::vector<std::unique_ptr<RawResource<T>>>> m_dead;
+        boost::signals2::scoped_connection m_onFrameCountChanged;
+
+        void resize(size_t frames);
     };
 
     using BufferAllocator = Allocator<vk::Buffer, vk::BufferCreateInfo>;
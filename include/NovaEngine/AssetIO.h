@@ -0,0 +1,136 @@
+#pragma once
+#include <VulkanWrapper/VulkanWrapper.h>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include "NovaEngine/StreamingTransfer.h"
+#include "NovaEngine/ThreadPool.h"
+#include "NovaEngine/ISystem.h"
+
+struct io_uring;
+
+namespace Nova {
+    class Engine;
+
+    using FileID = uint32_t;
+    using ReadID = uint64_t;
+
+    enum class ReadPriority {
+        High,
+        Normal,
+        Low
+    };
+
+    enum class ReadStatus {
+        Complete,
+        Cancelled,
+        Failed
+    };
+
+    struct ReadResult {
+        ReadID id;
+        ReadStatus status;
+        StreamID stream;    //for reads into a StreamingTransfer, the data is on the GPU once this stream is complete
+    };
+
+    using ReadCallback = std::function<void(const ReadResult& result)>;
+
+    //reads files asynchronously, through io_uring when NOVA_IO_URING is defined and on worker threads otherwise
+    //reads into a StreamingTransfer go straight into staging memory and are committed when they finish
+    //callbacks are called from update(), which should run before the StreamingTransfer's update
+    class AssetIO : public ISystem {
+        struct Request {
+            ReadID id;
+            FileID file;
+            uint64_t offset;
+            size_t size;
+            size_t issued;
+            size_t pending;
+            bool cancelled;
+            bool failed;
+            void* dest;
+            StreamingTransfer* stream;
+            const Buffer* buffer;
+            size_t dstOffset;
+            const Image* image;
+            vk::ImageLayout finalLayout;
+            vk::BufferImageCopy bufferImageCopy;
+            StreamID streamID;
+            ReadCallback callback;
+        };
+
+        struct Op {
+            ReadID id;
+            intptr_t handle;
+            char* dest;
+            uint64_t offset;
+            size_t size;
+            size_t done;
+            bool failed;
+            bool reserved;
+            StreamReservation reservation;
+        };
+
+        struct File {
+            intptr_t handle;
+            uint64_t size;
+        };
+
+    public:
+        AssetIO(Engine& engine, size_t queueDepth, size_t chunkSize);
+        AssetIO(const AssetIO& other) = delete;
+        AssetIO& operator = (const AssetIO& other) = delete;
+        AssetIO(AssetIO&& other) = delete;
+        AssetIO& operator = (AssetIO&& other) = delete;
+        ~AssetIO();
+
+        bool usingIoUring() const { return m_ring != nullptr; }
+
+        FileID open(const std::string& path);
+        //the file must not have any pending reads
+        void close(FileID file);
+        uint64_t fileSize(FileID file) const;
+
+        //dest must stay valid until the callback is called
+        ReadID read(ReadPriority priority, FileID file, uint64_t offset, size_t size, void* dest, ReadCallback callback = nullptr);
+        ReadID read(ReadPriority priority, FileID file, uint64_t offset, size_t size, StreamingTransfer& stream, const Buffer& buffer, size_t dstOffset, ReadCallback callback = nullptr);
+        //image data must be tightly packed and fit in one streaming page
+        ReadID read(ReadPriority priority, FileID file, uint64_t offset, StreamingTransfer& stream, const Image& image, vk::ImageLayout finalLayout, vk::BufferImageCopy copy, ReadCallback callback = nullptr);
+
+        //reads that have not been issued are dropped, reads already issued finish but report Cancelled
+        void cancel(ReadID id);
+        bool pending(ReadID id) const { return m_requests.count(id) > 0; }
+
+        void update(float delta) override;
+
+    private:
+        Engine* m_engine;
+        size_t m_queueDepth;
+        size_t m_chunkSize;
+        FileID m_nextFile = 1;
+        ReadID m_nextID = 1;
+        std::unordered_map<FileID, File> m_files;
+        std::unordered_map<ReadID, Request> m_requests;
+        std::array<std::deque<ReadID>, 3> m_queues;
+        std::unordered_map<StreamingTransfer*, size_t> m_reservations;
+        std::vector<std::unique_ptr<Op>> m_ops;
+        std::vector<Op*> m_freeOps;
+        size_t m_inFlight = 0;
+
+        std::unique_ptr<io_uring> m_ring;
+        std::vector<Op*> m_unsubmitted;     //ops that found the submission queue full
+        std::unique_ptr<ThreadPool> m_threadPool;
+        std::mutex m_mutex;
+        std::vector<Op*> m_completed;
+
+        ReadID enqueue(ReadPriority priority, Request request);
+        bool issue(Request& request);
+        void submit(Op& op);
+        void reap(std::vector<Op*>& completed);
+        void finish(Op& op);
+        void release(Request& request);
+    };
+}
@@ -4,6 +4,7 @@
 #include <glm/gtc/quaternion.hpp>
 #include "NovaEngine/Allocator.h"
 #include "NovaEngine/TransferNode.h"
+#include "NovaEngine/MirroredBuffer.h"
 #include "NovaEngine/CameraManager.h"
 
 namespace Nova {
@@ -26,7 +27,7 @@ namespace Nova {
 
         vk::DescriptorSetLayout& layout() const { return *m_layout; }
         vk::DescriptorSet& descriptor() const { return *m_descriptor; }
-        Buffer& buffer() const { return *m_buffer; }
+        Buffer& buffer() const { return m_buffer->buffer(); }
 
         glm::ivec2 size() const { return m_size; }
         glm::vec3 position() const { return m_pos; }
@@ -44,7 +45,7 @@ namespace Nova {
         std::unique_ptr<vk::DescriptorPool> m_descriptorPool;
         std::unique_ptr<vk::DescriptorSetLayout> m_layout;
         std::unique_ptr<vk::DescriptorSet> m_descriptor;
-        std::unique_ptr<Buffer> m_buffer;
+        std::unique_ptr<MirroredBuffer> m_buffer;
         glm::vec3 m_pos;
         glm::quat m_rot;
         glm::ivec2 m_size;
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Nova {
+    class ThreadPool;
+
+    enum class Codec : uint32_t {
+        Stored = 0,
+        LZ4 = 1,
+        Zstd = 2
+    };
+
+    //compressed data is split into independently compressed blocks, so blocks can be decompressed in parallel
+    //layout: CompressedHeader, uint32_t compressed size of each block, block data
+    struct CompressedHeader {
+        uint32_t magic;
+        Codec codec;
+        uint64_t size;
+        uint32_t blockSize;
+        uint32_t blockCount;
+    };
+
+    bool codecSupported(Codec codec);
+    std::vector<char> compress(Codec codec, const void* data, size_t size, size_t blockSize);
+    size_t decompressedSize(const void* data, size_t size);
+
+    //hostCached should be false when dest is write-combined memory
+    //blocks are then decompressed into a small cached buffer first, since the decoders read back what they have written
+    void decompress(const void* data, size_t size, void* dest, size_t destSize, bool hostCached, ThreadPool* threadPool = nullptr);
+}
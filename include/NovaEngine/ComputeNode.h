@@ -0,0 +1,59 @@
+#pragma once
+#include <VulkanWrapper/VulkanWrapper.h>
+#include "NovaEngine/FrameGraph.h"
+#include "NovaEngine/IResourceAllocator.h"
+
+namespace Nova {
+    //runs dispatches on the renderer's compute queue
+    //edges to nodes on other families wait on the compute timeline and transfer ownership of shared resources
+    class ComputeNode : public FrameNode {
+        struct Dispatch {
+            const vk::Pipeline* pipeline;
+            const vk::PipelineLayout* layout;
+            size_t firstSet;
+            size_t setCount;
+            size_t pushOffset;
+            size_t pushSize;
+            uint32_t groupCountX;
+            uint32_t groupCountY;
+            uint32_t groupCountZ;
+            const Buffer* indirectBuffer;
+            size_t indirectOffset;
+            bool barrier;
+        };
+
+    public:
+        ComputeNode(Engine& engine, FrameGraph& frameGraph);
+        ComputeNode(const ComputeNode& other) = delete;
+        ComputeNode& operator = (const ComputeNode& other) = delete;
+        ComputeNode(ComputeNode&& other) = default;
+        ComputeNode& operator = (ComputeNode&& other) = default;
+
+        bool hasWork() const override { return m_dispatches.size() > 0; }
+        std::vector<const vk::CommandBuffer*>& submit(size_t frame, size_t index) override;
+        //dispatches are queued per frame, so a skipped frame drops them with the resources added for them
+        void skip(size_t frame) override;
+
+        //resources read or written by dispatches, synchronized by the FrameGraph before the node runs
+        //buffers used for indirect dispatch need a usage with DrawIndirect and IndirectCommandRead
+        using FrameNode::addBufferUsage;
+        using FrameNode::addImageUsage;
+
+        //queued for this frame and recorded in order, push constants are copied
+        void dispatch(const vk::Pipeline& pipeline, const vk::PipelineLayout& layout, const std::vector<const vk::DescriptorSet*>& descriptorSets, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ, const void* pushConstants = nullptr, size_t pushSize = 0);
+        void dispatchIndirect(const vk::Pipeline& pipeline, const vk::PipelineLayout& layout, const std::vector<const vk::DescriptorSet*>& descriptorSets, const Buffer& buffer, size_t offset, const void* pushConstants = nullptr, size_t pushSize = 0);
+        //makes the writes of earlier dispatches visible to later ones, including their indirect arguments
+        void barrier();
+
+    private:
+        Engine* m_engine;
+        FrameGraph* m_frameGraph;
+        std::vector<const vk::CommandBuffer*> m_commandBuffers;
+        std::vector<Dispatch> m_dispatches;
+        std::vector<const vk::DescriptorSet*> m_descriptorSets;
+        std::vector<char> m_pushConstants;
+
+        void queue(Dispatch dispatch, const vk::Pipeline& pipeline, const vk::PipelineLayout& layout, const std::vector<const vk::DescriptorSet*>& descriptorSets, const void* pushConstants, size_t pushSize);
+        void record(vk::CommandBuffer& commandBuffer, const Dispatch& dispatch);
+    };
+}
@@ -6,6 +6,9 @@
 #include "NovaEngine/FrameGraph.h"
 #include "NovaEngine/ISystem.h"
 #include "NovaEngine/Clock.h"
+#include "NovaEngine/ThreadPool.h"
+#include "NovaEngine/TaskScheduler.h"
+#include "NovaEngine/FlightRecorder.h"
 
 namespace Nova {
     class Engine {
@@ -21,6 +24,12 @@ namespace Nova {
         Window& window() { return *m_window; }
         FrameGraph& frameGraph() { return *m_frameGraph; }
         const Clock& clock() const { return m_clock; }
+        ThreadPool& threadPool() { return *m_threadPool; }
+        TaskScheduler& tasks() { return *m_tasks; }
+        //nullptr until enableFlightRecorder is called
+        FlightRecorder* flightRecorder() { return m_flightRecorder.get(); }
+        //keeps the last frames from the next step on and dumps them when a frame is slower than the recorder's threshold
+        void enableFlightRecorder(size_t frames = 120);
 
         void addSystem(ISystem& system);
         void step();
@@ -32,6 +41,9 @@ namespace Nova {
         Window* m_window = nullptr;
         std::unique_ptr<Memory> m_memory;
         std::unique_ptr<FrameGraph> m_frameGraph;
+        std::unique_ptr<ThreadPool> m_threadPool;
+        std::unique_ptr<TaskScheduler> m_tasks;
+        std::unique_ptr<FlightRecorder> m_flightRecorder;
         std::vector<ISystem*> m_systems;
         Clock m_clock;
 
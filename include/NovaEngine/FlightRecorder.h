@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstdint>
+#include "NovaEngine/Trace.h"
+
+//always compiled, unlike NOVA_TRACE_ZONE, so the recorder keeps its zones in builds without NOVA_TRACE
+//the zone is also added to the trace when NOVA_TRACE is defined
+#define NOVA_FLIGHT_CONCAT_(a, b) a##b
+#define NOVA_FLIGHT_CONCAT(a, b) NOVA_FLIGHT_CONCAT_(a, b)
+#define NOVA_FLIGHT_ZONE(recorder, name) NOVA_TRACE_ZONE(name); ::Nova::FlightZone NOVA_FLIGHT_CONCAT(novaFlightZone, __LINE__)(recorder, name)
+
+namespace Nova {
+    class Engine;
+    class FrameNode;
+
+    //keeps a summary and the key CPU zones of the last frames in a fixed ring and writes them when a frame takes too long
+    //the ring is allocated up front and reused, so it can stay enabled in shipping builds
+    class FlightRecorder {
+        struct Zone {
+            const char* name;
+            uint64_t start;
+            uint64_t end;
+        };
+
+        struct NodeSample {
+            const FrameNode* node;
+            size_t frame;       //GPU timings are read back frames after they were submitted
+            double duration;    //milliseconds
+        };
+
+        struct Frame {
+            size_t frame = 0;
+            uint64_t start = 0;         //nanoseconds on the Trace clock
+            uint64_t end = 0;
+            double deltaTime = 0;
+            size_t allocations = 0;
+            size_t frees = 0;
+            size_t allocatedBytes = 0;
+            size_t pages = 0;
+            std::vector<NodeSample> nodes;
+            std::vector<Zone> zones;
+            size_t droppedZones = 0;
+        };
+
+    public:
+        //zones each frame keeps, later ones are counted as dropped
+        static constexpr size_t ZoneCapacity = 64;
+
+        FlightRecorder(Engine& engine, size_t frames);
+        FlightRecorder(const FlightRecorder& other) = delete;
+        FlightRecorder& operator = (const FlightRecorder& other) = delete;
+        FlightRecorder(FlightRecorder&& other) = default;
+        FlightRecorder& operator = (FlightRecorder&& other) = default;
+
+        size_t frames() const { return m_frames.size(); }
+        void setFrames(size_t frames);
+        //seconds, a frame with a larger Clock::deltaTime dumps the ring
+        double threshold() const { return m_threshold; }
+        void setThreshold(double threshold) { m_threshold = threshold; }
+        //dumps are written to <path>_<frame>.json
+        const std::string& path() const { return m_path; }
+        void setPath(const std::string& path) { m_path = path; }
+        //frames after a dump that can't dump again, so a run of slow frames writes one file
+        size_t cooldown() const { return m_cooldown; }
+        void setCooldown(size_t cooldown) { m_cooldown = cooldown; }
+        size_t dumps() const { return m_dumps; }
+
+        //called by the Engine at the start of every step, closes the previous frame and starts the next one
+        void update(double deltaTime);
+        //drops the frame being recorded and ignores the time until the next update, for steps that wait for the window
+        void skipFrame();
+        //adds a zone to the frame being recorded, must be called from the thread that calls Engine::step
+        void zone(const char* name, uint64_t start, uint64_t end);
+        //Chrome trace event format, a track of frame summaries and one of the recorded zones
+        //the NOVA_TRACE events since the oldest frame in the ring are included when NOVA_TRACE is defined
+        void write(std::ostream& stream) const;
+
+    private:
+        Engine* m_engine;
+        std::vector<Frame> m_frames;
+        size_t m_next = 0;
+        size_t m_count = 0;
+        double m_threshold = 0.1;
+        std::string m_path = "flight";
+        size_t m_cooldown = 60;
+        size_t m_lastDump = 0;
+        size_t m_dumps = 0;
+        size_t m_timingFrame = 0;
+        bool m_recording = false;
+
+        Frame& current() { return m_frames[(m_next + m_frames.size() - 1) % m_frames.size()]; }
+        void begin();
+        void end(double deltaTime);
+        void dump();
+    };
+    //records a zone into recorder from construction to destruction, nothing if recorder is nullptr
+    class FlightZone {
+    public:
+        FlightZone(FlightRecorder* recorder, const char* name) : m_recorder(recorder), m_name(name), m_start(recorder != nullptr ? Trace::now() : 0) {}
+        FlightZone(const FlightZone& other) = delete;
+        FlightZone& operator = (const FlightZone& other) = delete;
+        ~FlightZone() { if (m_recorder != nullptr) m_recorder->zone(m_name, m_start, Trace::now()); }
+
+    private:
+        FlightRecorder* m_recorder;
+        const char* m_name;
+        uint64_t m_start;
+    };
+}
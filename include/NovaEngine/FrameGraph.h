@@ -2,11 +2,16 @@
 #include <VulkanWrapper/VulkanWrapper.h>
 #include <type_traits>
 #include <unordered_set>
+#include <unordered_map>
+#include <functional>
 #include <boost/signals2.hpp>
 #include "NovaEngine/IResourceAllocator.h"
+#include "NovaEngine/ResourceStateTracker.h"
+#include "NovaEngine/GpuProfiler.h"
 
 namespace Nova {
     class Engine;
+    class Renderer;
     class FrameNode;
     class BufferUsage;
     class ImageUsage;
@@ -16,35 +21,89 @@ namespace Nova {
         friend class BufferUsage;
         friend class ImageUsage;
 
-        struct BufferBarrierInfo {
-            vk::BufferMemoryBarrier barrier;
-            vk::PipelineStageFlags source;
-            vk::PipelineStageFlags dest;
+        //buffers are released whole, like the ResourceStateTracker tracks them
+        struct BufferRelease {
+            vk::Buffer* buffer;
         };
 
-        struct ImageBarrierInfo {
-            vk::ImageMemoryBarrier barrier;
-            vk::PipelineStageFlags source;
-            vk::PipelineStageFlags dest;
+        struct ImageRelease {
+            vk::Image* image;
+            vk::ImageSubresourceRange range;
+            vk::ImageLayout layout;
         };
 
+        //edges across queues wait on the source queue's timeline, barriers come from the ResourceStateTracker
+        //edges across families also transfer ownership of the shared resources
+        //edges on one queue are split barriers, the source sets an event and the destination waits on it with the barriers
+        //of the resources the source accessed last, so work recorded in between isn't serialized by them
         struct Edge {
             Edge(FrameNode& source, FrameNode& dest);
-            void buildBarriers();
-            void recordSource(vk::CommandBuffer& commandBuffer);
-            void recordDest(vk::CommandBuffer& commandBuffer);
+            void buildReleases();
+            void addReleases(ResourceStateTracker& tracker, BarrierBatch& batch);
+            void createEvents(size_t frames);
+            void resetEvent(const vk::Device& device, size_t index);
 
             FrameNode* source;
             FrameNode* dest;
-            std::unique_ptr<vk::Event> event;
+            std::vector<BufferRelease> bufferReleases;
+            std::vector<ImageRelease> imageReleases;
+            //one event per frame index, reset from the host once the frame using it has completed
+            std::vector<std::unique_ptr<vk::Event>> events;
+            std::vector<bool> signaled;
+            BarrierBatch waitBarriers;
+            vk::PipelineStageFlags eventStages;
+            vk::Event* event = nullptr;     //set when the current frame has barriers to wait for
+        };
+
+        //every submission to the queue signals the next value
+        struct Timeline {
+            const vk::Queue* queue;
             std::unique_ptr<vk::Semaphore> semaphore;
-            std::vector<BufferBarrierInfo> sourceBufferBarriers;
-            std::vector<ImageBarrierInfo> sourceImageBarriers;
-            std::vector<BufferBarrierInfo> destBufferBarriers;
-            std::vector<ImageBarrierInfo> destImageBarriers;
+            uint64_t value = 0;
+            std::vector<vk::SubmitInfo> batch;
+        };
+
+        //bake lowers the graph into flat arrays indexed by submission position, so submit only walks arrays
+        struct ExecutionPlan {
+            std::vector<FrameNode*> nodes;
+            std::vector<size_t> timelines;
+            std::vector<size_t> serial;             //positions of nodes recorded on the calling thread
+            std::vector<size_t> parallel;           //positions of nodes recorded on the thread pool
+            //the sources of node i are sources[sourceOffsets[i]] to sources[sourceOffsets[i + 1]], dests likewise
+            std::vector<size_t> sourceOffsets;
+            std::vector<size_t> sources;
+            std::vector<size_t> destOffsets;
+            std::vector<size_t> dests;
+            //timeline values the completion of node i implies in the current frame, one row per node
+            //a submitted node only implies its own signal, a skipped node forwards the values of its sources
+            std::vector<uint64_t> frontiers;
+            std::vector<Edge*> releaseEdges;        //edges across families
+            std::vector<Edge*> eventEdges;          //edges on one queue
         };
 
     public:
+        //collects the barriers of every resource at one record point, so they are recorded with a single command
+        //with synchronization2 each barrier keeps its own stages, otherwise the stages of all barriers are merged
+        struct BarrierBatch {
+            std::vector<BufferBarrierInfo> buffers;
+            std::vector<ImageBarrierInfo> images;
+
+            void record(vk::CommandBuffer& commandBuffer, const Renderer& renderer);
+            void clear();
+        };
+
+        struct SubmitStats {
+            size_t queueSubmits = 0;        //vkQueueSubmit calls made by the last frame
+            size_t submitInfos = 0;         //node submissions batched into those calls
+            size_t skippedNodes = 0;        //disabled or culled nodes
+            size_t totalQueueSubmits = 0;
+        };
+
+        enum class BakeMode {
+            Manual,
+            InferEdges
+        };
+
         FrameGraph(Engine& engine, size_t frameCount);
         FrameGraph(const FrameGraph& other) = delete;
         FrameGraph& operator = (const FrameGraph& other) = delete;
@@ -54,25 +113,51 @@ namespace Nova {
         size_t frame() const { return m_frame; }
         size_t frameCount() const { return m_frameCount; }
         boost::signals2::signal<void(size_t)>& onFrameCountChanged() { return m_onFrameCountChanged; }
+        ResourceStateTracker& resourceStates() { return m_resourceStates; }
+        const SubmitStats& submitStats() const { return m_submitStats; }
+        //nullptr until enableProfiling is called
+        GpuProfiler* profiler() { return m_profiler.get(); }
+        //timestamps the work of every node from the next submit on, requires VK_EXT_host_query_reset
+        void enableProfiling();
 
         void addNode(FrameNode& node);
         void addEdge(FrameNode& source, FrameNode& dest);
-        void bake();
+        //waits only for the frames in flight that use the node or its neighbours, the graph doesn't need to be baked again
+        void removeNode(FrameNode& node);
+        //InferEdges adds the read after write, write after read and write after write edges implied by declared usages
+        //nodes access their resources in registration order, edges already implied by other edges are left out
+        //baking again after adding nodes or edges doesn't wait for frames in flight
+        void bake(BakeMode mode = BakeMode::Manual);
+        //waits for the graph's frames in flight, since nodes and allocators index their per frame resources by frame index
+        void setFrameCount(size_t frames);
         void submit();
         size_t completedFrames() const;
 
     private:
         Engine* m_engine;
         std::vector<FrameNode*> m_nodes;
-        std::vector<FrameNode*> m_nodeList;
+        ExecutionPlan m_plan;
         size_t m_frameCount;
         size_t m_frame = 1;
         std::vector<std::unique_ptr<Edge>> m_edges;
-        std::vector<std::vector<vk::Fence>> m_fences;
+        std::vector<Timeline> m_timelines;
+        //timeline values each frame index has to reach before it can be reused
+        std::vector<std::vector<uint64_t>> m_frameValues;
+        ResourceStateTracker m_resourceStates;
+        //node that accessed each resource last while planning the current frame
+        std::unordered_map<const void*, FrameNode*> m_lastAccess;
+        SubmitStats m_submitStats;
+        std::vector<uint64_t> m_waits;
+        std::vector<const vk::CommandBuffer*> m_noCommandBuffers;
+        std::unique_ptr<GpuProfiler> m_profiler;
         boost::signals2::signal<void(size_t)> m_onFrameCountChanged;
 
         void setFrames(size_t frames);
-        void preSignal();
+        void createFrameResources();
+        size_t timeline(const vk::Queue& queue);
+        void wait(const std::vector<uint64_t>& values);
+        void inferEdges();
+        void compile(std::vector<FrameNode*> order);
     };
 
     class BufferUsage {
@@ -90,6 +175,8 @@ namespace Nova {
         BufferUsage(FrameNode* node, vk::PipelineStageFlags stageMask, vk::AccessFlags accessMask);
 
         void add(const Buffer& buffer, size_t offset, size_t size);
+        //used every frame without calling add, and visible to FrameGraph::bake for edge inference
+        void declare(const Buffer& buffer, size_t offset, size_t size);
 
     private:
         FrameNode* m_node;
@@ -111,6 +198,8 @@ namespace Nova {
         ImageUsage(FrameNode* node, vk::PipelineStageFlags stageMask, vk::AccessFlags accessMask, vk::ImageLayout layout);
 
         void add(const Image& image, vk::ImageSubresourceRange range);
+        //used every frame without calling add, and visible to FrameGraph::bake for edge inference
+        void declare(const Image& image, vk::ImageSubresourceRange range);
 
     private:
         FrameNode* m_node;
@@ -134,44 +223,110 @@ namespace Nova {
 
         const vk::Queue& queue() const { return *m_queue; }
         FrameGraph& graph() { return *m_graph; }
+        //shown in profiler traces
+        const std::string& name() const { return m_name; }
+        void setName(const std::string& name) { m_name = name; }
+        //disabled nodes are skipped from the next submit on, their edges forward the synchronization and ownership releases of their sources
+        //work queued on a skipped node and the resources it added to its usages are kept until it runs, unless its skip() drops them
+        //TransferNode keeps its uploads, ComputeNode drops the dispatches of the frames it misses
+        bool enabled() const { return m_enabled; }
+        void setEnabled(bool enabled) { m_enabled = enabled; }
+        //cullable nodes are skipped in frames where no node that runs consumes them through an edge
+        bool cullable() const { return m_cullable; }
+        void setCullable(bool cullable) { m_cullable = cullable; }
         void addExternalWait(vk::Semaphore& semaphore, vk::PipelineStageFlags stageMask);
         void addExternalSignal(vk::Semaphore& semaphore);
 
         void preRecord(vk::CommandBuffer& commandBuffer);
         void postRecord(vk::CommandBuffer& commandBuffer);
+        //waits on the events of in-edges on the same queue, called by preRecord unless defersEventWaits returns true
+        void recordEventWaits(vk::CommandBuffer& commandBuffer);
 
+        //called for enabled nodes and for disabled ones with external semaphores, which are still submitted
         virtual void preSubmit(size_t frame) {};
+        //called after preSubmit, nodes without work are skipped like disabled ones
+        //skipped nodes with external semaphores are still submitted, without command buffers, so the semaphores are signaled
+        virtual bool hasWork() const { return true; }
+        //called on a worker thread, concurrently with other nodes, unless recordsInParallel returns false
         virtual std::vector<const vk::CommandBuffer*>& submit(size_t frame, size_t index) = 0;
         virtual void postSubmit(size_t frame) {};
+        //called instead of submit and postSubmit in frames the node is skipped
+        virtual void skip(size_t frame) {};
+
+        //nodes that touch state shared with other nodes while recording are recorded on the calling thread
+        //queried when the graph is baked
+        virtual bool recordsInParallel() const { return true; }
 
     protected:
         vk::CommandPool& commandPool() const { return *m_pool; }
         std::vector<vk::CommandBuffer>& commandBuffers() { return m_commandBuffers; }
+
+        //called in submission order before any node records, for accesses the node's usages don't describe
+        //the ResourceStateTracker must not be used from submit, which may run on another thread
+        //resources used here must also be in the node's usages, so later nodes know who accessed them last
+        virtual void planResources(ResourceStateTracker& tracker) {}
+
+        //nodes that return true call recordEventWaits themselves, as late as possible before using their resources
+        virtual bool defersEventWaits() const { return false; }
+
+        //drops the resources added to the node's usages since it last ran, for skip() implementations that drop their work
+        void clearInstances();
+
+        //records count secondary command buffers on the engine's thread pool, each slot has its own command pool
+        //the returned buffers are in slot order and are executed from the node's primary command buffer
+        std::vector<vk::CommandBuffer>& recordSecondary(size_t index, size_t count, const vk::CommandBufferBeginInfo& beginInfo, const std::function<void(vk::CommandBuffer& commandBuffer, size_t slot)>& record);
         BufferUsage& addBufferUsage(vk::PipelineStageFlags stageMask, vk::AccessFlags accessMask);
         ImageUsage& addImageUsage(vk::PipelineStageFlags stageMask, vk::AccessFlags accessMask, vk::ImageLayout layout);
 
     private:
         FrameGraph* m_graph;
+        std::string m_name;
         const vk::Queue* m_queue;
         uint32_t m_family;
         vk::SubmitInfo m_submitInfo;
         vk::PipelineStageFlags m_sourceStages;
         vk::PipelineStageFlags m_destStages;
-        std::unique_ptr<vk::Semaphore> m_selfSync;
         std::unique_ptr<vk::CommandPool> m_pool;
         std::vector<vk::CommandBuffer> m_commandBuffers;
         std::vector<FrameGraph::Edge*> m_inEvents;
         std::vector<FrameGraph::Edge*> m_outEvents;
+        FrameGraph::BarrierBatch m_preBarriers;
+        FrameGraph::BarrierBatch m_postBarriers;
+        std::vector<const vk::CommandBuffer*>* m_recorded = nullptr;
+        std::vector<std::unique_ptr<vk::CommandPool>> m_secondaryPools;
+        std::vector<std::vector<vk::CommandBuffer>> m_secondaryBuffers;
         std::vector<std::unique_ptr<BufferUsage>> m_bufferUsages;
         std::vector<std::unique_ptr<ImageUsage>> m_imageUsages;
-        std::unordered_map<vk::Buffer*, BufferUsage::Instance> m_bufferMap;
-        std::unordered_map<vk::Image*, ImageUsage::Instance> m_imageMap;
+        //sorted by resource in compileInstances, so edges can match both sides with a linear merge
+        std::vector<BufferUsage::Instance> m_buffers;
+        std::vector<ImageUsage::Instance> m_images;
+        std::vector<BufferUsage::Instance> m_declaredBuffers;
+        std::vector<ImageUsage::Instance> m_declaredImages;
+        size_t m_timeline = 0;
+        uint64_t m_timelineValue = 0;       //value signaled by the node's last submission
+        bool m_enabled = true;
+        bool m_cullable = false;
+        bool m_active = false;              //records and submits in the current frame
+        bool m_submitted = false;           //submitted in the current frame, with or without commands
+        uint32_t m_query = GpuProfiler::NoQuery;
+        //semaphores of the frame submit info only change when the graph is baked, external ones are added
+        //or disabled nodes change which timelines the node waits on
+        bool m_submitDirty = true;
+        size_t m_externalWaits = 0;
+        uint64_t m_waitMask = 0;
+        vk::SubmitInfo m_frameSubmitInfo;
+        VkTimelineSemaphoreSubmitInfoKHR m_timelineInfo;
+        std::vector<uint64_t> m_waitValues;
+        std::vector<uint64_t> m_signalValues;
 
         void createCommandPool();
         void createCommandBuffers(size_t frames);
-        bool addBuffer(vk::Buffer& buffer, BufferUsage::Instance usage);
-        bool addImage(vk::Image& image, ImageUsage::Instance usage);
-        void clearInstances();
-        void submit(size_t frame, size_t index, vk::Fence& fence);
+        void compileInstances();
+        bool hasExternalSemaphores() const { return m_submitInfo.waitSemaphores.size() > 0 || m_submitInfo.signalSemaphores.size() > 0; }
+        void planBarriers();
+        void forwardReleases(ResourceStateTracker& tracker);
+        FrameGraph::Edge* eventEdge(const void* resource);
+        void compileSubmit(uint64_t waitMask);
+        const vk::SubmitInfo& buildSubmit(const std::vector<uint64_t>& waits);
     };
 }
\ No newline at end of file
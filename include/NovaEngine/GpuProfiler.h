@@ -0,0 +1,110 @@
+#pragma once
+#include <VulkanWrapper/VulkanWrapper.h>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <memory>
+#include <cstdint>
+
+namespace Nova {
+    class Renderer;
+    class FrameNode;
+
+    //GPU durations of one FrameNode, in milliseconds
+    class NodeTiming {
+        friend class GpuProfiler;
+
+    public:
+        double last() const { return m_last; }
+        double average() const { return m_average; }
+        //over the most recent samples, p in [0, 1]
+        double percentile(double p) const;
+        size_t sampleCount() const { return m_samples.size(); }
+        //the frame the last sample was submitted in
+        size_t frame() const { return m_frame; }
+
+    private:
+        double m_last = 0;
+        size_t m_frame = 0;
+        double m_average = 0;
+        double m_sum = 0;
+        std::vector<double> m_samples;
+        size_t m_next = 0;
+
+        void add(double duration, size_t window);
+    };
+
+    //writes timestamps around the work of every FrameNode, with one query pool per frame in flight
+    //results are read when the FrameGraph reuses a frame index, after it waited on that frame, so reading never stalls
+    class GpuProfiler {
+        //the queries of a frame index, node i uses queries 2i and 2i + 1
+        struct Frame {
+            std::unique_ptr<vk::QueryPool> pool;
+            uint32_t capacity = 0;
+            size_t frame = 0;
+            uint64_t submitTime = 0;
+            std::vector<const FrameNode*> nodes;
+            std::vector<uint32_t> families;
+            bool pending = false;
+        };
+
+        struct TraceEvent {
+            const FrameNode* node;
+            uint32_t family;
+            uint64_t start;     //nanoseconds on the GPU clock
+            uint64_t duration;  //nanoseconds
+        };
+
+    public:
+        static constexpr uint32_t NoQuery = ~0u;
+
+        GpuProfiler(Renderer& renderer, size_t frameCount);
+        GpuProfiler(const GpuProfiler& other) = delete;
+        GpuProfiler& operator = (const GpuProfiler& other) = delete;
+        GpuProfiler(GpuProfiler&& other) = default;
+        GpuProfiler& operator = (GpuProfiler&& other) = default;
+
+        //microseconds of the clock the CPU side of a trace uses
+        static uint64_t cpuTime();
+
+        size_t window() const { return m_window; }
+        void setWindow(size_t window) { m_window = window; }
+        //nullptr until the node's first frame has been read back
+        const NodeTiming* timing(const FrameNode& node) const;
+        //nodes are removed when the FrameGraph removes them
+        const std::unordered_map<const FrameNode*, NodeTiming>& timings() const { return m_timings; }
+
+        //while capturing, every node's GPU work is kept for writeTrace
+        bool capturing() const { return m_capturing; }
+        void setCapturing(bool capturing) { m_capturing = capturing; }
+        void clearTrace() { m_events.clear(); }
+        //Chrome trace event format, each queue family is a thread of the GPU process
+        void writeTrace(std::ostream& stream) const;
+        //the comma separated events of writeTrace without the enclosing object, so they can be merged into another trace
+        void writeEvents(std::ostream& stream) const;
+
+        //called by the FrameGraph after it waited on the frame index
+        void beginFrame(size_t frame, size_t index);
+        uint32_t addNode(const FrameNode& node, uint32_t family);
+        void endFrame(size_t index);
+        void writeTimestamp(vk::CommandBuffer& commandBuffer, VkPipelineStageFlagBits stage, uint32_t query) const;
+        void resize(size_t frames);
+        void forget(const FrameNode& node);
+
+    private:
+        Renderer* m_renderer;
+        std::vector<Frame> m_frames;
+        size_t m_current = 0;
+        std::unordered_map<const FrameNode*, NodeTiming> m_timings;
+        size_t m_window = 256;
+        //smallest difference between the GPU and CPU clocks seen so far, GPU work never starts before it was submitted
+        int64_t m_clockOffset = INT64_MAX;
+        bool m_capturing = false;
+        std::vector<TraceEvent> m_events;
+        std::vector<uint64_t> m_results;
+
+        void resolve(Frame& frame);
+        void reset(Frame& frame);
+    };
+}
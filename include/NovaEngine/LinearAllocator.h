@@ -10,6 +10,8 @@ namespace Nova {
         LinearAllocator(LinearAllocator&& other) = default;
         LinearAllocator& operator = (LinearAllocator&& other) = default;
 
+        size_t used() const { return m_ptr - m_offset; }
+
         Allocation allocate(size_t size, size_t alignment) override;
         void free(Allocation allocation) override;
         void reset() override;
@@ -36,6 +36,14 @@ namespace Nova {
             void* m_mapping = nullptr;
         };
 
+        //totals since the Memory was created
+        struct Stats {
+            size_t allocations = 0;
+            size_t frees = 0;
+            size_t allocatedBytes = 0;
+            size_t pages = 0;
+        };
+
         Memory(Engine& engine);
         Memory(const Memory& other) = delete;
         Memory& operator = (const Memory& other) = delete;
@@ -43,6 +51,7 @@ namespace Nova {
         Memory& operator = (Memory&& other) = default;
 
         const vk::MemoryProperties& properties() const { return m_properties; }
+        const Stats& stats() const { return m_stats; }
 
         MemoryAllocation allocate(uint32_t type, size_t size);
         void free(MemoryAllocation allocation);
@@ -56,6 +65,7 @@ namespace Nova {
         vk::MemoryProperties m_properties;
         std::vector<std::vector<std::unique_ptr<Page>>> m_pages;
         std::unordered_set<IResourceAllocatorBase*> m_resourceAllocators;
+        Stats m_stats;
     };
     
     struct MemoryAllocation {
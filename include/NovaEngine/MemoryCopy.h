@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+
+namespace Nova {
+    enum class CopyKernel {
+        Memcpy,
+        SSE2Stream,
+        AVX2Stream
+    };
+
+    bool copyKernelSupported(CopyKernel kernel);
+    CopyKernel streamingCopyKernel();
+    const char* copyKernelName(CopyKernel kernel);
+
+    void copyMemory(void* dest, const void* src, size_t size, CopyKernel kernel);
+
+    //copy into mapped device memory
+    //memory that isn't HostCached is usually write-combined, so non-temporal stores are used to avoid reading it into the cache
+    void copyToMapped(void* dest, const void* src, size_t size, bool hostCached);
+}
@@ -20,6 +20,8 @@ namespace Nova {
         Buffer& buffer() const { return *m_buffer; }
 
         void fill(TransferNode& transferNode, const void* data, size_t vertexCount);
+        //uploads only the given vertices, the buffer must already be large enough
+        void update(TransferNode& transferNode, const void* data, size_t firstVertex, size_t vertexCount);
 
     private:
         BufferAllocator* m_allocator;
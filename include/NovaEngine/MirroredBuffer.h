@@ -0,0 +1,43 @@
+#pragma once
+#include <VulkanWrapper/VulkanWrapper.h>
+#include "NovaEngine/Allocator.h"
+
+namespace Nova {
+    class TransferNode;
+
+    //keeps a CPU copy of a device local buffer
+    //writes are collected into dirty ranges and only those ranges are uploaded when the TransferNode is submitted
+    class MirroredBuffer {
+        friend class TransferNode;
+
+        struct Range {
+            size_t offset;
+            size_t size;
+        };
+
+    public:
+        MirroredBuffer(BufferAllocator& allocator, const vk::BufferCreateInfo& info);
+        MirroredBuffer(const MirroredBuffer& other) = delete;
+        MirroredBuffer& operator = (const MirroredBuffer& other) = delete;
+        MirroredBuffer(MirroredBuffer&& other) = delete;
+        MirroredBuffer& operator = (MirroredBuffer&& other) = delete;
+        ~MirroredBuffer();
+
+        Buffer& buffer() const { return *m_buffer; }
+        size_t size() const { return m_data.size(); }
+        const void* data() const { return m_data.data(); }
+
+        void write(TransferNode& transferNode, size_t offset, const void* data, size_t size);
+        //returns the CPU copy of the range, which the caller may modify until the TransferNode is submitted
+        void* map(TransferNode& transferNode, size_t offset, size_t size);
+
+    private:
+        std::unique_ptr<Buffer> m_buffer;
+        std::vector<char> m_data;
+        std::vector<Range> m_dirty;
+        TransferNode* m_transferNode = nullptr;
+
+        void markDirty(TransferNode& transferNode, size_t offset, size_t size);
+        void flush(TransferNode& transferNode);
+    };
+}
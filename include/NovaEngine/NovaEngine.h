@@ -2,8 +2,21 @@
 #include <NovaEngine/Engine.h>
 #include <NovaEngine/Window.h>
 #include <NovaEngine/FrameGraph.h>
+#include <NovaEngine/ResourceStateTracker.h>
+#include <NovaEngine/GpuProfiler.h>
+#include <NovaEngine/Trace.h>
+#include <NovaEngine/FlightRecorder.h>
 #include <NovaEngine/Allocator.h>
 #include <NovaEngine/TransferNode.h>
+#include <NovaEngine/ComputeNode.h>
+#include <NovaEngine/UploadScheduler.h>
+#include <NovaEngine/ReadbackNode.h>
+#include <NovaEngine/MirroredBuffer.h>
+#include <NovaEngine/StreamingTransfer.h>
+#include <NovaEngine/AssetIO.h>
+#include <NovaEngine/TaskScheduler.h>
+#include <NovaEngine/ThreadPool.h>
+#include <NovaEngine/Compression.h>
 #include <NovaEngine/CameraManager.h>
 #include <NovaEngine/Camera.h>
 #include <NovaEngine/PerspectiveCamera.h>
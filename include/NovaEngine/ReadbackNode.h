@@ -0,0 +1,76 @@
+#pragma once
+#include <VulkanWrapper/VulkanWrapper.h>
+#include "NovaEngine/FrameGraph.h"
+#include "NovaEngine/IResourceAllocator.h"
+#include "NovaEngine/StagingAllocator.h"
+#include <boost/signals2.hpp>
+
+namespace Nova {
+    class ReadbackNode;
+
+    class ReadbackResult {
+        friend class ReadbackNode;
+
+    public:
+        bool ready() const { return m_ready; }
+        size_t frame() const { return m_frame; }
+        const std::vector<char>& data() const { return m_data; }
+
+    private:
+        bool m_ready = false;
+        size_t m_frame = 0;
+        std::vector<char> m_data;
+    };
+
+    using ReadbackHandle = std::shared_ptr<ReadbackResult>;
+
+    class ReadbackNode : public FrameNode {
+        struct Readback {
+            const Buffer* buffer;
+            const Image* image;
+            vk::BufferCopy bufferCopy;
+            vk::BufferImageCopy bufferImageCopy;
+            size_t size;
+            StagingRange range;
+            ReadbackHandle result;
+        };
+
+    public:
+        ReadbackNode(Engine& engine, const vk::Queue& queue, FrameGraph& frameGraph, size_t pageSize);
+        ReadbackNode(const ReadbackNode& other) = delete;
+        ReadbackNode& operator = (const ReadbackNode& other) = delete;
+        ReadbackNode(ReadbackNode&& other) = default;
+        ReadbackNode& operator = (ReadbackNode&& other) = default;
+
+        bool hasWork() const override { return m_readbacks.size() > 0; }
+        //results are resolved once completedFrames() passes the frame they were recorded in, whether or not the node runs
+        void preSubmit(size_t frame) override;
+        std::vector<const vk::CommandBuffer*>& submit(size_t frame, size_t index) override;
+        void skip(size_t frame) override;
+
+        //results become ready after the frame they were recorded in has completed
+        //the image is transitioned from whatever layout the FrameGraph last left it in
+        ReadbackHandle readback(const Buffer& buffer, vk::BufferCopy copy);
+        ReadbackHandle readback(const Image& image, vk::BufferImageCopy copy);
+
+    private:
+        Engine* m_engine;
+        FrameGraph* m_frameGraph;
+        BufferUsage* m_bufferUsage;
+        ImageUsage* m_imageUsage;
+        boost::signals2::scoped_connection m_onFrameCountChanged;
+        std::vector<const vk::CommandBuffer*> m_commandBuffers;
+        std::vector<StagingAllocator> m_allocators;
+        std::vector<std::vector<Readback>> m_pending;
+        size_t m_pageSize;
+        uint32_t m_type;
+        std::vector<Readback> m_readbacks;
+
+        void findType();
+        bool findType(vk::MemoryPropertyFlags flags);
+        void resize(size_t frames);
+        void resolve(size_t index);
+        void resolveCompleted();
+        void record(vk::CommandBuffer& commandBuffer, StagingAllocator& allocator, Readback& readback);
+    };
+}
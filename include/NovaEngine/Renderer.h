@@ -23,6 +23,26 @@ namespace Nova {
         const vk::Queue& graphicsQueue() const { return *m_graphicsQueue; }
         const vk::Queue& presentQueue() const { return *m_presentQueue; }
         const vk::Queue& transferQueue() const { return *m_transferQueue; }
+        //a compute only family when the device has one, so dispatches can overlap graphics work, otherwise the graphics queue
+        const vk::Queue& computeQueue() const { return *m_computeQueue; }
+
+        //VK_KHR_timeline_semaphore and its feature are required, the FrameGraph paces frames with one timeline per queue
+        //the instance enables VK_KHR_get_physical_device_properties2, which the extension depends on
+        PFN_vkWaitSemaphoresKHR waitSemaphores() const { return m_waitSemaphores; }
+        PFN_vkGetSemaphoreCounterValueKHR getSemaphoreCounterValue() const { return m_getSemaphoreCounterValue; }
+
+        //enabled when VK_KHR_synchronization2 is passed to createDevice and the device supports the feature
+        bool synchronization2() const { return m_synchronization2; }
+#ifdef VK_KHR_synchronization2
+        PFN_vkCmdPipelineBarrier2KHR cmdPipelineBarrier2() const { return m_cmdPipelineBarrier2; }
+#endif
+
+        //enabled when VK_EXT_host_query_reset is passed to createDevice and the device supports the feature, needed for GPU profiling
+        bool hostQueryReset() const { return m_hostQueryReset; }
+        PFN_vkResetQueryPoolEXT resetQueryPool() const { return m_resetQueryPool; }
+        //nanoseconds per timestamp tick, and the valid timestamp bits of each queue family, zero if it has no timestamps
+        float timestampPeriod() const { return m_timestampPeriod; }
+        uint32_t timestampValidBits(uint32_t family) const { return m_timestampValidBits[family]; }
 
         void createDevice(const vk::PhysicalDevice& physicalDevice, const std::vector<std::string>& extensions, vk::PhysicalDeviceFeatures* features);
 
@@ -33,6 +53,17 @@ namespace Nova {
         const vk::Queue* m_graphicsQueue;
         const vk::Queue* m_presentQueue;
         const vk::Queue* m_transferQueue;
+        const vk::Queue* m_computeQueue;
+        PFN_vkWaitSemaphoresKHR m_waitSemaphores = nullptr;
+        PFN_vkGetSemaphoreCounterValueKHR m_getSemaphoreCounterValue = nullptr;
+        bool m_synchronization2 = false;
+#ifdef VK_KHR_synchronization2
+        PFN_vkCmdPipelineBarrier2KHR m_cmdPipelineBarrier2 = nullptr;
+#endif
+        bool m_hostQueryReset = false;
+        PFN_vkResetQueryPoolEXT m_resetQueryPool = nullptr;
+        float m_timestampPeriod = 0;
+        std::vector<uint32_t> m_timestampValidBits;
 
         void createInstance(const std::string& appName, const std::vector<std::string>& extensions, const std::vector<std::string>& layers);
     };
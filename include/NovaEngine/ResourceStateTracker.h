@@ -0,0 +1,106 @@
+#pragma once
+#include <VulkanWrapper/VulkanWrapper.h>
+#include <unordered_map>
+#include <vector>
+#include <functional>
+
+namespace Nova {
+    struct BufferBarrierInfo {
+        vk::BufferMemoryBarrier barrier;
+        vk::PipelineStageFlags source;
+        vk::PipelineStageFlags dest;
+    };
+
+    struct ImageBarrierInfo {
+        vk::ImageMemoryBarrier barrier;
+        vk::PipelineStageFlags source;
+        vk::PipelineStageFlags dest;
+    };
+
+    struct ResourceAccess {
+        vk::PipelineStageFlags stages;
+        vk::AccessFlags access;
+        vk::ImageLayout layout;     //ignored for buffers
+        uint32_t family;
+    };
+
+    //tracks how every buffer and image subresource was last used, in submission order and across frames
+    //barriers are derived from that state, so redundant transitions and read after read barriers are skipped
+    //image aspects are tracked together, buffers are tracked as a whole
+    class ResourceStateTracker {
+        struct State {
+            vk::ImageLayout layout;
+            uint32_t family;
+            vk::PipelineStageFlags writeStages;
+            vk::AccessFlags writeAccess;
+            vk::PipelineStageFlags readStages;
+            vk::PipelineStageFlags visibleStages;   //stages the last write has been made visible to
+            vk::AccessFlags visibleAccess;
+            uint32_t releasedTo;                    //family a pending queue ownership transfer is released to
+            vk::ImageLayout releasedLayout;
+        };
+
+        struct Transition {
+            bool needed;
+            vk::PipelineStageFlags srcStages;
+            vk::PipelineStageFlags dstStages;
+            vk::AccessFlags srcAccess;
+            vk::AccessFlags dstAccess;
+            vk::ImageLayout oldLayout;
+            vk::ImageLayout newLayout;
+            uint32_t srcFamily;
+            uint32_t dstFamily;
+
+            bool operator == (const Transition& other) const;
+        };
+
+        struct ImageState {
+            uint32_t levels;
+            uint32_t layers;
+            std::vector<State> states;
+        };
+
+    public:
+        ResourceStateTracker() = default;
+        ResourceStateTracker(const ResourceStateTracker& other) = delete;
+        ResourceStateTracker& operator = (const ResourceStateTracker& other) = delete;
+        ResourceStateTracker(ResourceStateTracker&& other) = default;
+        ResourceStateTracker& operator = (ResourceStateTracker&& other) = default;
+
+        static bool isWrite(vk::AccessFlags access);
+
+        vk::ImageLayout layout(const vk::Image& image, uint32_t level, uint32_t layer) const;
+
+        //true if family can use the resource without an ownership transfer, or one to family is pending
+        bool owned(const vk::Buffer& buffer, uint32_t family) const;
+        bool owned(const vk::Image& image, vk::ImageSubresourceRange range, uint32_t family) const;
+
+        //appends the barriers needed before the resource is accessed and records the access
+        //an access on a family that doesn't own the resource discards its contents, or throws if it reads them
+        //buffer state covers the whole buffer, so buffer barriers do too, a barrier for only the accessed range would miss earlier writes elsewhere
+        void use(const vk::Buffer& buffer, const ResourceAccess& access, std::vector<BufferBarrierInfo>& barriers);
+        void use(const vk::Image& image, vk::ImageSubresourceRange range, const ResourceAccess& access, std::vector<ImageBarrierInfo>& barriers);
+
+        //appends the release half of a queue family ownership transfer, the next use on dstFamily acquires it
+        void release(const vk::Buffer& buffer, uint32_t family, uint32_t dstFamily, std::vector<BufferBarrierInfo>& barriers);
+        void release(const vk::Image& image, vk::ImageSubresourceRange range, uint32_t family, uint32_t dstFamily, vk::ImageLayout layout, std::vector<ImageBarrierInfo>& barriers);
+
+        //for work synchronized outside of the FrameGraph, the resource is idle and owned by family afterwards
+        void reset(const vk::Buffer& buffer, uint32_t family);
+        void reset(const vk::Image& image, vk::ImageSubresourceRange range, vk::ImageLayout layout, uint32_t family);
+
+        void forget(const vk::Buffer& buffer);
+        void forget(const vk::Image& image);
+
+    private:
+        std::unordered_map<const vk::Buffer*, State> m_buffers;
+        std::unordered_map<const vk::Image*, ImageState> m_images;
+
+        static State initialState();
+        static bool owned(const State& state, uint32_t family);
+        static Transition apply(State& state, const ResourceAccess& access, bool image);
+        static Transition applyRelease(State& state, uint32_t family, uint32_t dstFamily, vk::ImageLayout layout);
+        ImageState& imageState(const vk::Image& image);
+        void addImageBarriers(const vk::Image& image, vk::ImageSubresourceRange range, std::vector<ImageBarrierInfo>& barriers, const std::function<Transition(State&)>& function);
+    };
+}
@@ -6,9 +6,15 @@
 namespace Nova {
     class Engine;
 
+    struct StagingRange {
+        void* data;
+        size_t offset;
+        size_t size;
+    };
+
     class StagingAllocator {
     public:
-        StagingAllocator(Engine& engine, size_t pageSize, uint32_t type);
+        StagingAllocator(Engine& engine, size_t pageSize, uint32_t type, vk::BufferUsageFlags usage = vk::BufferUsageFlags::TransferSrc);
         StagingAllocator(const StagingAllocator& other) = delete;
         StagingAllocator& operator = (const StagingAllocator& other) = delete;
         StagingAllocator(StagingAllocator&& other);
@@ -16,7 +22,12 @@ namespace Nova {
         ~StagingAllocator();
 
         vk::Buffer& buffer() const { return *m_buffer; }
+        vk::MemoryPropertyFlags flags() const { return m_page.memory->flags(); }
+
+        void* mapping() const;
+        size_t used() const { return m_allocator->used(); }
 
+        StagingRange reserve(size_t size);
         size_t stage(const void* data, size_t size);
         void reset();
 
@@ -0,0 +1,105 @@
+#pragma once
+#include <VulkanWrapper/VulkanWrapper.h>
+#include <deque>
+#include <map>
+#include <functional>
+#include "NovaEngine/IResourceAllocator.h"
+#include "NovaEngine/StagingAllocator.h"
+#include "NovaEngine/ISystem.h"
+
+namespace Nova {
+    class Engine;
+
+    using StreamID = uint64_t;
+
+    struct StreamReservation {
+        void* data;
+        size_t size;
+        StreamID id;
+        size_t copy;
+    };
+
+    //uploads on the transfer queue independently of the FrameGraph
+    //each staging page is submitted as one batch that signals its id on a timeline semaphore, so batches complete in order and a StreamID is complete once every earlier one is
+    //resources must not be used by FrameGraph nodes until complete() returns true
+    class StreamingTransfer : public ISystem {
+        struct Copy {
+            const Buffer* buffer;
+            const Image* image;
+            vk::BufferCopy bufferCopy;
+            vk::BufferImageCopy bufferImageCopy;
+            vk::ImageLayout finalLayout;
+            bool cancelled;
+        };
+
+        struct Batch {
+            std::unique_ptr<StagingAllocator> staging;
+            std::vector<Copy> copies;
+            size_t uncommitted;
+            StreamID id;
+        };
+
+    public:
+        StreamingTransfer(Engine& engine, size_t pageSize, size_t pageCount);
+        StreamingTransfer(const StreamingTransfer& other) = delete;
+        StreamingTransfer& operator = (const StreamingTransfer& other) = delete;
+        StreamingTransfer(StreamingTransfer&& other) = default;
+        StreamingTransfer& operator = (StreamingTransfer&& other) = default;
+        ~StreamingTransfer();
+
+        size_t pageSize() const { return m_pageSize; }
+        size_t pageCount() const { return m_batches.size(); }
+        StreamID completed() const { return m_completed; }
+        bool complete(StreamID id) const { return id <= m_completed; }
+
+        //reserved memory can be filled from any thread, but reserve() and commit() must be called from the thread that calls update()
+        //a batch is not submitted until all of its reservations are committed
+        StreamReservation reserve(size_t size, const Buffer& buffer, size_t dstOffset);
+        StreamReservation reserve(const Image& image, vk::ImageLayout finalLayout, vk::BufferImageCopy copy);
+        void commit(const StreamReservation& reservation);
+        //true if reserving size bytes won't wait for the GPU, completed batches are retired to make room
+        bool canReserve(size_t size);
+        //the reservation's copy is dropped, so whatever was written to its memory never reaches the resource
+        void cancel(const StreamReservation& reservation);
+
+        StreamID upload(const void* data, size_t size, const Buffer& buffer, size_t dstOffset);
+        StreamID upload(const void* data, const Image& image, vk::ImageLayout finalLayout, vk::BufferImageCopy copy);
+
+        //callback is called from update() once id is complete, or immediately if it already is
+        void onComplete(StreamID id, std::function<void()> callback);
+
+        void flush();
+        void update(float delta) override;
+
+    private:
+        Engine* m_engine;
+        const vk::Queue* m_transferQueue;
+        const vk::Queue* m_graphicsQueue;
+        size_t m_pageSize;
+        uint32_t m_type;
+        std::unique_ptr<vk::Semaphore> m_timeline;
+        std::unique_ptr<vk::Semaphore> m_copied;
+        std::unique_ptr<vk::CommandPool> m_transferPool;
+        std::unique_ptr<vk::CommandPool> m_graphicsPool;
+        std::vector<vk::CommandBuffer> m_transferCommands;
+        std::vector<vk::CommandBuffer> m_acquireCommands;
+        std::vector<Batch> m_batches;
+        std::vector<size_t> m_free;
+        std::deque<size_t> m_inFlight;
+        std::vector<size_t> m_closed;
+        size_t m_open;
+        StreamID m_next = 1;
+        StreamID m_completed = 0;
+        std::multimap<StreamID, std::function<void()>> m_callbacks;
+
+        bool ownershipTransfer() const { return m_transferQueue->familyIndex() != m_graphicsQueue->familyIndex(); }
+        void findType();
+        std::unique_ptr<vk::Semaphore> createTimeline();
+        void createCommandBuffers(size_t count);
+        Batch& openBatch(size_t size);
+        void close();
+        void submit(size_t index);
+        bool retire(bool wait);
+        void record(size_t index);
+    };
+}
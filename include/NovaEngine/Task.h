@@ -0,0 +1,65 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace Nova {
+    class TaskScheduler;
+
+    //coroutine that starts suspended and runs when it is spawned on a TaskScheduler or awaited by another Task
+    //exceptions are rethrown in the awaiting Task, or from TaskScheduler::update for spawned tasks
+    class Task {
+    public:
+        struct promise_type;
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+            void await_resume() noexcept {}
+        };
+
+        struct promise_type {
+            std::coroutine_handle<> continuation;
+            TaskScheduler* scheduler = nullptr;
+            std::exception_ptr exception;
+
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            FinalAwaiter final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { exception = std::current_exception(); }
+        };
+
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept { return handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+                handle.promise().continuation = caller;
+                return handle;
+            }
+
+            void await_resume() {
+                if (handle.promise().exception) std::rethrow_exception(handle.promise().exception);
+            }
+        };
+
+        Task(const Task& other) = delete;
+        Task& operator = (const Task& other) = delete;
+        Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        Task& operator = (Task&& other) noexcept;
+        ~Task();
+
+        bool done() const { return m_handle == nullptr || m_handle.done(); }
+
+        Awaiter operator co_await() && { return { m_handle }; }
+
+    private:
+        friend class TaskScheduler;
+        std::coroutine_handle<promise_type> m_handle;
+
+        explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+        std::coroutine_handle<promise_type> release() { return std::exchange(m_handle, nullptr); }
+    };
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <queue>
+#include <unordered_set>
+#include <vector>
+#include <functional>
+#include <memory>
+#include "NovaEngine/Task.h"
+#include "NovaEngine/AssetIO.h"
+#include "NovaEngine/StreamingTransfer.h"
+#include "NovaEngine/UploadScheduler.h"
+
+namespace Nova {
+    class Engine;
+
+    //resumes suspended Tasks from Engine::step, after systems are updated and before the FrameGraph is submitted
+    //waiting tasks are only touched when what they wait for happens, so they cost nothing per frame
+    class TaskScheduler {
+        struct FrameWaiter {
+            size_t frame;
+            std::coroutine_handle<> handle;
+
+            bool operator > (const FrameWaiter& other) const { return frame > other.frame; }
+        };
+
+        //owned by the awaiter in the suspended coroutine frame, callbacks registered elsewhere only hold a weak_ptr
+        //so a callback that fires after the frame was destroyed does nothing
+        struct Waiter {
+            TaskScheduler* scheduler;
+            std::coroutine_handle<> handle;
+        };
+
+    public:
+        struct NextFrame {
+            TaskScheduler* scheduler;
+
+            bool await_ready() { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler->m_ready.push_back(handle); }
+            void await_resume() {}
+        };
+
+        struct FrameComplete {
+            TaskScheduler* scheduler;
+            size_t frame;
+
+            bool await_ready();
+            void await_suspend(std::coroutine_handle<> handle) { scheduler->m_frames.push({ frame, handle }); }
+            void await_resume() {}
+        };
+
+        struct StreamComplete {
+            TaskScheduler* scheduler;
+            StreamingTransfer* stream;
+            StreamID id;
+
+            std::shared_ptr<Waiter> waiter;
+
+            bool await_ready() { return stream->complete(id); }
+            void await_suspend(std::coroutine_handle<> handle);
+            void await_resume() {}
+        };
+
+        struct UploadComplete {
+            TaskScheduler* scheduler;
+            UploadScheduler* uploads;
+            UploadID id;
+
+            std::shared_ptr<Waiter> waiter;
+
+            bool await_ready() { return uploads->complete(id); }
+            void await_suspend(std::coroutine_handle<> handle);
+            void await_resume() {}
+        };
+
+        struct ReadComplete {
+            TaskScheduler* scheduler;
+            std::function<void(ReadCallback callback)> issue;
+            ReadResult result;
+            std::shared_ptr<Waiter> waiter;
+
+            bool await_ready() { return false; }
+            void await_suspend(std::coroutine_handle<> handle);
+            ReadResult await_resume() { return result; }
+        };
+
+        TaskScheduler(Engine& engine);
+        TaskScheduler(const TaskScheduler& other) = delete;
+        TaskScheduler& operator = (const TaskScheduler& other) = delete;
+        TaskScheduler(TaskScheduler&& other) = delete;
+        TaskScheduler& operator = (TaskScheduler&& other) = delete;
+        ~TaskScheduler();
+
+        size_t taskCount() const { return m_tasks.size(); }
+
+        //runs the task until its first suspension, the scheduler then owns it
+        //tasks still suspended when the scheduler is destroyed are destroyed with it
+        void spawn(Task task);
+
+        NextFrame nextFrame() { return { this }; }
+        //work recorded during a frame, such as TransferNode transfers, is finished once that frame is complete
+        FrameComplete frameComplete(size_t frame) { return { this, frame }; }
+        StreamComplete streamComplete(StreamingTransfer& stream, StreamID id) { return { this, &stream, id }; }
+        UploadComplete uploadComplete(UploadScheduler& uploads, UploadID id) { return { this, &uploads, id }; }
+
+        ReadComplete read(AssetIO& io, ReadPriority priority, FileID file, uint64_t offset, size_t size, void* dest);
+        ReadComplete read(AssetIO& io, ReadPriority priority, FileID file, uint64_t offset, size_t size, StreamingTransfer& stream, const Buffer& buffer, size_t dstOffset);
+        ReadComplete read(AssetIO& io, ReadPriority priority, FileID file, uint64_t offset, StreamingTransfer& stream, const Image& image, vk::ImageLayout finalLayout, vk::BufferImageCopy copy);
+
+        void update();
+
+    private:
+        friend class Task;
+        Engine* m_engine;
+        std::unordered_set<void*> m_tasks;
+        std::vector<std::coroutine_handle<>> m_ready;
+        std::priority_queue<FrameWaiter, std::vector<FrameWaiter>, std::greater<FrameWaiter>> m_frames;
+        std::vector<std::coroutine_handle<Task::promise_type>> m_finished;
+
+        void collect();
+        static void wake(const std::weak_ptr<Waiter>& waiter);
+    };
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Nova {
+    class ThreadPool {
+    public:
+        ThreadPool(size_t threadCount);
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool& operator = (const ThreadPool& other) = delete;
+        ThreadPool(ThreadPool&& other) = delete;
+        ThreadPool& operator = (ThreadPool&& other) = delete;
+        ~ThreadPool();
+
+        size_t threadCount() const { return m_threads.size(); }
+
+        void enqueue(std::function<void()> job);
+        //runs function(i) for i in [0, count) and returns when all have finished
+        //the calling thread works on the jobs too
+        void parallelFor(size_t count, const std::function<void(size_t)>& function);
+
+    private:
+        std::vector<std::thread> m_threads;
+        std::deque<std::function<void()>> m_jobs;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        bool m_stop = false;
+
+        void work();
+    };
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstdint>
+
+//zones and frame markers are compiled out unless NOVA_TRACE is defined
+#ifdef NOVA_TRACE
+#define NOVA_TRACE_CONCAT_(a, b) a##b
+#define NOVA_TRACE_CONCAT(a, b) NOVA_TRACE_CONCAT_(a, b)
+#define NOVA_TRACE_ZONE(name) ::Nova::TraceZone NOVA_TRACE_CONCAT(novaTraceZone, __LINE__)(name)
+#define NOVA_TRACE_FRAME(number) ::Nova::Trace::frame(number)
+#else
+#define NOVA_TRACE_ZONE(name)
+#define NOVA_TRACE_FRAME(number)
+#endif
+
+namespace Nova {
+    class GpuProfiler;
+
+    class Trace {
+        struct Event {
+            const char* name;       //nullptr for frame markers
+            uint64_t start;         //nanoseconds
+            uint64_t end;           //frame number for frame markers
+        };
+
+        //written only by its thread, readers check the head again after copying to drop overwritten events
+        struct Buffer {
+            std::vector<Event> events;
+            std::atomic<uint64_t> head = 0;
+            size_t thread;
+        };
+
+        struct Registry;
+
+    public:
+        //events each thread keeps before the oldest are overwritten
+        static constexpr size_t Capacity = 1 << 16;
+
+        //nanoseconds on the same clock as GpuProfiler::cpuTime
+        static uint64_t now();
+
+        static void zone(const char* name, uint64_t start, uint64_t end);
+        static void frame(size_t frame);
+
+        //Chrome trace event format with one thread per recording thread, GPU work is added when a profiler is given
+        static void write(std::ostream& stream, const GpuProfiler* profiler = nullptr);
+        //the comma separated events of write without the enclosing object, leaving out events that ended before since
+        static void writeEvents(std::ostream& stream, uint64_t since = 0);
+        //trace timestamps are microseconds, written with nanosecond decimals
+        static void writeTime(std::ostream& stream, uint64_t nanoseconds);
+        //a quoted and escaped JSON string
+        static void writeString(std::ostream& stream, const std::string& string);
+
+    private:
+        static Registry& registry();
+        static Buffer& buffer();
+    };
+
+    class TraceZone {
+    public:
+        TraceZone(const char* name) : m_name(name), m_start(Trace::now()) {}
+        TraceZone(const TraceZone& other) = delete;
+        TraceZone& operator = (const TraceZone& other) = delete;
+        ~TraceZone() { Trace::zone(m_name, m_start, Trace::now()); }
+
+    private:
+        const char* m_name;
+        uint64_t m_start;
+    };
+}
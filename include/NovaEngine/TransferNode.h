@@ -3,16 +3,21 @@
 #include "NovaEngine/FrameGraph.h"
 #include "NovaEngine/IResourceAllocator.h"
 #include "NovaEngine/StagingAllocator.h"
+#include "NovaEngine/MirroredBuffer.h"
 #include <boost/signals2.hpp>
 
 namespace Nova {
     class TransferNode : public FrameNode {
+        friend class MirroredBuffer;
+
         struct Transfer {
             const Buffer* buffer;
             const Image* image;
             vk::BufferCopy bufferCopy;
             vk::BufferImageCopy bufferImageCopy;
             vk::ImageLayout imageLayout;
+            bool generateMipmaps;
+            size_t allocator;           //staging allocator of the frame the transfer was queued in
         };
 
     public:
@@ -22,11 +27,27 @@ namespace Nova {
         TransferNode(TransferNode&& other) = default;
         TransferNode& operator = (TransferNode&& other) = default;
 
+        void preSubmit(size_t frame) override;
+        bool hasWork() const override { return m_transfers.size() > 0; }
         std::vector<const vk::CommandBuffer*>& submit(size_t frame, size_t index) override;
 
         void transfer(const void* data, const Buffer& buffer, vk::BufferCopy copy);
         void transfer(const void* data, const Image& image, vk::ImageLayout imageLayout, vk::BufferImageCopy copy);
 
+        //decompresses data produced by compress() directly into staging memory
+        //large payloads are decompressed in parallel on the engine's thread pool
+        void transferCompressed(const void* data, size_t size, const Buffer& buffer, size_t dstOffset);
+        void transferCompressed(const void* data, size_t size, const Image& image, vk::ImageLayout imageLayout, vk::BufferImageCopy copy);
+
+        //uploads mip 0 and generates the remaining mip levels with blits
+        //requires a queue that supports graphics and a format that supports blitting
+        void transferMipmapped(const void* data, const Image& image, vk::ImageLayout imageLayout, vk::BufferImageCopy copy);
+
+        //returns mapped memory that will be copied to the destination this frame
+        //must be filled before the FrameGraph is submitted
+        void* reserve(size_t size, const Buffer& buffer, size_t dstOffset);
+        void* reserve(const Image& image, vk::ImageLayout imageLayout, vk::BufferImageCopy copy);
+
     private:
         Engine* m_engine;
         FrameGraph* m_frameGraph;
@@ -38,9 +59,15 @@ namespace Nova {
         size_t m_pageSize;
         uint32_t m_type;
         std::vector<Transfer> m_transfers;
+        std::vector<MirroredBuffer*> m_mirrors;
+        FrameGraph::BarrierBatch m_layoutBarriers;
 
         void findType();
+        void planResources(ResourceStateTracker& tracker) override;
+        void recordMipmaps(vk::CommandBuffer& commandBuffer, const Transfer& transfer);
         size_t getFrame();
         void resize(size_t frames);
+        void addMirror(MirroredBuffer& mirror);
+        void removeMirror(MirroredBuffer& mirror);
     };
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+#include <VulkanWrapper/VulkanWrapper.h>
+#include <array>
+#include <deque>
+#include <unordered_set>
+#include <unordered_map>
+#include <functional>
+#include "NovaEngine/TransferNode.h"
+#include "NovaEngine/ISystem.h"
+
+namespace Nova {
+    enum class UploadPriority {
+        Critical,   //sent to the TransferNode immediately, ignores the budget
+        High,
+        Normal,
+        Low
+    };
+
+    using UploadID = uint64_t;
+
+    //spreads uploads over multiple frames so that no frame transfers more than the budget
+    //images are split by rows and must not be used by other nodes until the upload is complete
+
+    class UploadScheduler : public ISystem {
+        struct Upload {
+            UploadID id;
+            std::vector<char> data;
+            const Buffer* buffer;
+            const Image* image;
+            size_t dstOffset;
+            vk::BufferImageCopy bufferImageCopy;
+            vk::ImageLayout imageLayout;
+            size_t progress;
+        };
+
+        struct InFlight {
+            size_t frame;
+            UploadID id;
+        };
+
+    public:
+        UploadScheduler(Engine& engine, TransferNode& transferNode, size_t frameBudget, size_t chunkSize);
+        UploadScheduler(const UploadScheduler& other) = delete;
+        UploadScheduler& operator = (const UploadScheduler& other) = delete;
+        UploadScheduler(UploadScheduler&& other) = default;
+        UploadScheduler& operator = (UploadScheduler&& other) = default;
+
+        size_t frameBudget() const { return m_frameBudget; }
+        void setFrameBudget(size_t frameBudget) { m_frameBudget = frameBudget; }
+        size_t chunkSize() const { return m_chunkSize; }
+        void setChunkSize(size_t chunkSize) { m_chunkSize = chunkSize; }
+
+        UploadID upload(UploadPriority priority, const void* data, size_t size, const Buffer& buffer, size_t dstOffset);
+        UploadID upload(UploadPriority priority, const void* data, const Image& image, vk::ImageLayout imageLayout, vk::BufferImageCopy copy);
+        bool complete(UploadID id) const;
+        //callback is called from update() once id is complete, or immediately if it already is
+        void onComplete(UploadID id, std::function<void()> callback);
+
+        void update(float delta) override;
+
+    private:
+        Engine* m_engine;
+        TransferNode* m_transferNode;
+        size_t m_frameBudget;
+        size_t m_chunkSize;
+        UploadID m_nextID = 1;
+        std::array<std::deque<Upload>, 3> m_queues;
+        std::deque<InFlight> m_inFlight;
+        std::unordered_set<UploadID> m_waiting;
+        std::unordered_multimap<UploadID, std::function<void()>> m_callbacks;
+
+        UploadID enqueue(UploadPriority priority, Upload upload);
+        size_t send(Upload& upload, size_t budget);
+        size_t sendBuffer(Upload& upload, size_t budget);
+        size_t sendImage(Upload& upload, size_t budget);
+        void retire();
+    };
+}
@@ -7,6 +7,7 @@ template<typename T, typename TCreateInfo>
 Allocator<T, TCreateInfo>::Allocator(Engine& engine, size_t pageSize) : IResourceAllocator(engine), m_allocator(engine, pageSize) {
     m_engine = &engine;
     m_dead.resize(m_engine->frameGraph().frameCount());
+    m_onFrameCountChanged = m_engine->frameGraph().onFrameCountChanged().connect(boost::bind(&Allocator::resize, this, _1));
 }
 
 template<typename T, typename TCreateInfo>
@@ -20,6 +21,7 @@ Resource<T, TCreateInfo> Allocator<T, TCreateInfo>::allocate(const TCreateInfo&
 template<typename T, typename TCreateInfo>
 void Allocator<T, TCreateInfo>::free(RawResource<T>* resource) {
     size_t frame = m_engine->frameGraph().frame() % m_engine->frameGraph().frameCount();
+    m_engine->frameGraph().resourceStates().forget(resource->resource);
     m_dead[frame].emplace_back(std::move(m_resources[resource]));
 }
 
@@ -29,5 +31,15 @@ void Allocator<T, TCreateInfo>::update(size_t completed) {
     m_dead[frame].clear();
 }
 
+template<typename T, typename TCreateInfo>
+void Allocator<T, TCreateInfo>::resize(size_t frames) {
+    //the FrameGraph waited for its frames in flight, so none of the dead resources are in use
+    for (auto& dead : m_dead) {
+        dead.clear();
+    }
+
+    m_dead.resize(frames);
+}
+
 template class Allocator<vk::Buffer, vk::BufferCreateInfo>;
 template class Allocator<vk::Image, vk::ImageCreateInfo>;
\ No newline at end of file
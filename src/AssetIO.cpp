@@ -0,0 +1,442 @@
+#include "NovaEngine/AssetIO.h"
+#include "NovaEngine/Engine.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#endif
+
+#ifdef NOVA_IO_URING
+#include <liburing.h>
+#else
+struct io_uring {};
+#endif
+
+#define FALLBACK_THREADS 4
+
+using namespace Nova;
+
+namespace {
+    bool readAt(intptr_t handle, char* dest, size_t size, uint64_t offset) {
+        size_t done = 0;
+
+        while (done < size) {
+#ifdef _WIN32
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = static_cast<DWORD>(offset + done);
+            overlapped.OffsetHigh = static_cast<DWORD>((offset + done) >> 32);
+
+            DWORD toRead = static_cast<DWORD>(std::min<size_t>(size - done, 1u << 30));
+            DWORD result = 0;
+            if (!ReadFile(reinterpret_cast<HANDLE>(handle), dest + done, toRead, &result, &overlapped)) return false;
+#else
+            ssize_t result = pread(static_cast<int>(handle), dest + done, size - done, static_cast<off_t>(offset + done));
+            if (result < 0 && errno == EINTR) continue;
+            if (result < 0) return false;
+#endif
+            if (result == 0) return false;
+            done += static_cast<size_t>(result);
+        }
+
+        return true;
+    }
+}
+
+AssetIO::AssetIO(Engine& engine, size_t queueDepth, size_t chunkSize) {
+    if (queueDepth == 0 || chunkSize == 0) throw std::runtime_error("Invalid AssetIO configuration");
+
+    m_engine = &engine;
+    m_queueDepth = queueDepth;
+    m_chunkSize = chunkSize;
+
+#ifdef NOVA_IO_URING
+    //kernels without io_uring support fall back to worker threads
+    auto ring = std::make_unique<io_uring>();
+    if (io_uring_queue_init(static_cast<unsigned>(queueDepth), ring.get(), 0) == 0) {
+        m_ring = std::move(ring);
+    }
+#endif
+
+    if (m_ring == nullptr) {
+        m_threadPool = std::make_unique<ThreadPool>(std::min<size_t>(queueDepth, FALLBACK_THREADS));
+    }
+}
+
+AssetIO::~AssetIO() {
+    //reads still in flight write into their destinations, so they must finish first
+#ifdef NOVA_IO_URING
+    if (m_ring != nullptr) {
+        io_uring_submit(m_ring.get());
+
+        for (; m_inFlight > 0; m_inFlight--) {
+            io_uring_cqe* cqe;
+            if (io_uring_wait_cqe(m_ring.get(), &cqe) != 0) break;
+            io_uring_cqe_seen(m_ring.get(), cqe);
+        }
+
+        io_uring_queue_exit(m_ring.get());
+    }
+#endif
+
+    m_threadPool.reset();
+
+    for (auto& pair : m_files) {
+#ifdef _WIN32
+        CloseHandle(reinterpret_cast<HANDLE>(pair.second.handle));
+#else
+        ::close(static_cast<int>(pair.second.handle));
+#endif
+    }
+}
+
+FileID AssetIO::open(const std::string& path) {
+    File file = {};
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) throw std::runtime_error("Could not open file " + path);
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size)) {
+        CloseHandle(handle);
+        throw std::runtime_error("Could not get size of file " + path);
+    }
+
+    file.handle = reinterpret_cast<intptr_t>(handle);
+    file.size = static_cast<uint64_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("Could not open file " + path);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not get size of file " + path);
+    }
+
+    file.handle = fd;
+    file.size = static_cast<uint64_t>(info.st_size);
+#endif
+
+    FileID id = m_nextFile++;
+    m_files[id] = file;
+    return id;
+}
+
+void AssetIO::close(FileID file) {
+    auto it = m_files.find(file);
+    if (it == m_files.end()) throw std::runtime_error("File is not open");
+
+    for (auto& pair : m_requests) {
+        if (pair.second.file == file) throw std::runtime_error("File has pending reads");
+    }
+
+#ifdef _WIN32
+    CloseHandle(reinterpret_cast<HANDLE>(it->second.handle));
+#else
+    ::close(static_cast<int>(it->second.handle));
+#endif
+
+    m_files.erase(it);
+}
+
+uint64_t AssetIO::fileSize(FileID file) const {
+    auto it = m_files.find(file);
+    if (it == m_files.end()) throw std::runtime_error("File is not open");
+    return it->second.size;
+}
+
+ReadID AssetIO::read(ReadPriority priority, FileID file, uint64_t offset, size_t size, void* dest, ReadCallback callback) {
+    Request request = {};
+    request.file = file;
+    request.offset = offset;
+    request.size = size;
+    request.dest = dest;
+    request.callback = std::move(callback);
+
+    return enqueue(priority, std::move(request));
+}
+
+ReadID AssetIO::read(ReadPriority priority, FileID file, uint64_t offset, size_t size, StreamingTransfer& stream, const Buffer& buffer, size_t dstOffset, ReadCallback callback) {
+    Request request = {};
+    request.file = file;
+    request.offset = offset;
+    request.size = size;
+    request.stream = &stream;
+    request.buffer = &buffer;
+    request.dstOffset = dstOffset;
+    request.callback = std::move(callback);
+
+    return enqueue(priority, std::move(request));
+}
+
+ReadID AssetIO::read(ReadPriority priority, FileID file, uint64_t offset, StreamingTransfer& stream, const Image& image, vk::ImageLayout finalLayout, vk::BufferImageCopy copy, ReadCallback callback) {
+    size_t texels = copy.imageExtent.width * copy.imageExtent.height * copy.imageExtent.depth;
+    size_t size = texels * vk::getFormatSize(image.resource().format());
+    if (size > stream.pageSize()) throw std::runtime_error("Image read too large for streaming page");
+
+    Request request = {};
+    request.file = file;
+    request.offset = offset;
+    request.size = size;
+    request.stream = &stream;
+    request.image = &image;
+    request.finalLayout = finalLayout;
+    request.bufferImageCopy = copy;
+    request.callback = std::move(callback);
+
+    return enqueue(priority, std::move(request));
+}
+
+ReadID AssetIO::enqueue(ReadPriority priority, Request request) {
+    auto it = m_files.find(request.file);
+    if (it == m_files.end()) throw std::runtime_error("File is not open");
+    if (request.offset + request.size > it->second.size) throw std::runtime_error("Read past end of file");
+
+    ReadID id = m_nextID++;
+    request.id = id;
+
+    if (request.size == 0) {
+        if (request.callback) request.callback({ id, ReadStatus::Complete, 0 });
+        return id;
+    }
+
+    m_requests.emplace(id, std::move(request));
+    m_queues[static_cast<size_t>(priority)].push_back(id);
+    return id;
+}
+
+void AssetIO::cancel(ReadID id) {
+    auto it = m_requests.find(id);
+    if (it == m_requests.end()) return;
+
+    Request& request = it->second;
+    request.cancelled = true;
+
+    //otherwise the request is released when its last read finishes
+    if (request.pending == 0) {
+        release(request);
+    }
+}
+
+void AssetIO::update(float delta) {
+    std::vector<Op*> completed;
+    reap(completed);
+
+    for (auto op : completed) {
+        finish(*op);
+    }
+
+#ifdef NOVA_IO_URING
+    //ops that didn't fit in the submission queue go first, submit may defer them again
+    std::vector<Op*> unsubmitted;
+    unsubmitted.swap(m_unsubmitted);
+
+    for (auto op : unsubmitted) {
+        submit(*op);
+    }
+#endif
+
+    bool blocked = false;
+
+    for (auto& queue : m_queues) {
+        while (!blocked && queue.size() > 0 && m_inFlight < m_queueDepth) {
+            auto it = m_requests.find(queue.front());
+
+            if (it == m_requests.end() || it->second.cancelled || it->second.failed) {
+                queue.pop_front();
+                continue;
+            }
+
+            Request& request = it->second;
+
+            //keeps priority order, lower priority reads don't overtake a read waiting for staging space
+            if (!issue(request)) {
+                blocked = true;
+                break;
+            }
+
+            if (request.issued == request.size) {
+                queue.pop_front();
+            }
+        }
+    }
+
+#ifdef NOVA_IO_URING
+    //every read queued this frame goes to the kernel in one call
+    if (m_ring != nullptr) {
+        io_uring_submit(m_ring.get());
+    }
+#endif
+}
+
+bool AssetIO::issue(Request& request) {
+    size_t size = request.size - request.issued;
+
+    if (request.image == nullptr) {
+        size = std::min(size, m_chunkSize);
+    }
+
+    if (request.stream != nullptr) {
+        if (request.image == nullptr) {
+            size = std::min(size, request.stream->pageSize());
+        }
+
+        //each reservation holds at most one page until it is committed, so leave a page free for other uploads
+        //one read is always allowed, otherwise a stream with a single page would never make progress
+        size_t& reservations = m_reservations[request.stream];
+        if (reservations > 0 && reservations + 1 >= request.stream->pageCount()) return false;
+
+        //reserving would otherwise wait for the GPU to free a page, the read is deferred to a later update instead
+        if (!request.stream->canReserve(size)) return false;
+        reservations++;
+    }
+
+    Op* op;
+    if (m_freeOps.size() > 0) {
+        op = m_freeOps.back();
+        m_freeOps.pop_back();
+    } else {
+        m_ops.push_back(std::make_unique<Op>());
+        op = m_ops.back().get();
+    }
+
+    *op = {};
+    op->id = request.id;
+    op->handle = m_files[request.file].handle;
+    op->offset = request.offset + request.issued;
+    op->size = size;
+
+    if (request.stream != nullptr) {
+        if (request.image != nullptr) {
+            op->reservation = request.stream->reserve(*request.image, request.finalLayout, request.bufferImageCopy);
+        } else {
+            op->reservation = request.stream->reserve(size, *request.buffer, request.dstOffset + request.issued);
+        }
+
+        op->reserved = true;
+        op->dest = static_cast<char*>(op->reservation.data);
+        request.streamID = std::max(request.streamID, op->reservation.id);
+    } else {
+        op->dest = static_cast<char*>(request.dest) + request.issued;
+    }
+
+    request.issued += size;
+    request.pending++;
+    m_inFlight++;
+
+    submit(*op);
+    return true;
+}
+
+void AssetIO::submit(Op& op) {
+#ifdef NOVA_IO_URING
+    if (m_ring != nullptr) {
+        io_uring_sqe* sqe = io_uring_get_sqe(m_ring.get());
+        if (sqe == nullptr) {
+            io_uring_submit(m_ring.get());
+            sqe = io_uring_get_sqe(m_ring.get());
+        }
+
+        //the submission queue is still full, for example when the kernel returned -EBUSY, so the op is retried by update
+        if (sqe == nullptr) {
+            m_unsubmitted.push_back(&op);
+            return;
+        }
+
+        io_uring_prep_read(sqe, static_cast<int>(op.handle), op.dest + op.done, static_cast<unsigned>(op.size - op.done), op.offset + op.done);
+        io_uring_sqe_set_data(sqe, &op);
+        return;
+    }
+#endif
+
+    Op* ptr = &op;
+    m_threadPool->enqueue([this, ptr] {
+        ptr->failed = !readAt(ptr->handle, ptr->dest, ptr->size, ptr->offset);
+        ptr->done = ptr->size;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_completed.push_back(ptr);
+    });
+}
+
+void AssetIO::reap(std::vector<Op*>& completed) {
+#ifdef NOVA_IO_URING
+    if (m_ring != nullptr) {
+        io_uring_cqe* cqe;
+
+        while (io_uring_peek_cqe(m_ring.get(), &cqe) == 0) {
+            Op* op = static_cast<Op*>(io_uring_cqe_get_data(cqe));
+            int result = cqe->res;
+            io_uring_cqe_seen(m_ring.get(), cqe);
+
+            if (result == -EINTR || result == -EAGAIN) {
+                submit(*op);
+                continue;
+            }
+
+            if (result <= 0) {
+                op->failed = true;
+                completed.push_back(op);
+                continue;
+            }
+
+            //short reads are continued from where they stopped
+            op->done += static_cast<size_t>(result);
+            if (op->done < op->size) {
+                submit(*op);
+            } else {
+                completed.push_back(op);
+            }
+        }
+
+        return;
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    completed.insert(completed.end(), m_completed.begin(), m_completed.end());
+    m_completed.clear();
+}
+
+void AssetIO::finish(Op& op) {
+    m_inFlight--;
+    m_freeOps.push_back(&op);
+
+    Request& request = m_requests.at(op.id);
+    request.pending--;
+    if (op.failed) request.failed = true;
+
+    //the batch can't be submitted until every reservation in it is settled, failed reads are cancelled so their staging memory is never copied
+    if (op.reserved) {
+        if (op.failed) {
+            request.stream->cancel(op.reservation);
+        } else {
+            request.stream->commit(op.reservation);
+        }
+
+        m_reservations[request.stream]--;
+    }
+
+    if (request.pending == 0 && (request.issued == request.size || request.cancelled || request.failed)) {
+        release(request);
+    }
+}
+
+void AssetIO::release(Request& request) {
+    ReadResult result = {};
+    result.id = request.id;
+    result.status = request.failed ? ReadStatus::Failed : request.cancelled ? ReadStatus::Cancelled : ReadStatus::Complete;
+    result.stream = request.streamID;
+
+    ReadCallback callback = std::move(request.callback);
+    m_requests.erase(request.id);
+
+    if (callback) callback(result);
+}
@@ -41,10 +41,10 @@ void Camera::update(TransferNode& transferNode) {
     info.rotationView = glm::lookAtRH({}, forward, up);
     info.projection = getProjection();
 
-    vk::BufferCopy copy = {};
-    copy.size = sizeof(info);
-
-    transferNode.transfer(&info, *m_buffer, copy);
+    //only upload when the camera has actually changed
+    if (memcmp(&info, m_buffer->data(), sizeof(info)) != 0) {
+        m_buffer->write(transferNode, 0, &info, sizeof(info));
+    }
 }
 
 void Camera::createPool() {
@@ -77,7 +77,7 @@ void Camera::createBuffer() {
     info.size = sizeof(CameraInfo);
     info.usage = vk::BufferUsageFlags::UniformBuffer | vk::BufferUsageFlags::TransferDst;
 
-    m_buffer = std::make_unique<Buffer>(m_manager->allocator().allocate(info, vk::MemoryPropertyFlags::DeviceLocal, {}));
+    m_buffer = std::make_unique<MirroredBuffer>(m_manager->allocator(), info);
 }
 
 void Camera::createDescriptor() {
@@ -88,7 +88,7 @@ void Camera::createDescriptor() {
     m_descriptor = std::make_unique<vk::DescriptorSet>(std::move(m_descriptorPool->allocate(info)[0]));
 
     vk::DescriptorBufferInfo bufferInfo = {};
-    bufferInfo.buffer = &m_buffer->resource();
+    bufferInfo.buffer = &m_buffer->buffer().resource();
     bufferInfo.range = VK_WHOLE_SIZE;
 
     vk::WriteDescriptorSet write = {};
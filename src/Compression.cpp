@@ -0,0 +1,217 @@
+#include "NovaEngine/Compression.h"
+#include "NovaEngine/ThreadPool.h"
+#include "NovaEngine/MemoryCopy.h"
+#include <cstring>
+#include <stdexcept>
+#include <memory>
+
+#ifdef NOVA_LZ4
+#include <lz4.h>
+#endif
+#ifdef NOVA_ZSTD
+#include <zstd.h>
+#endif
+
+#define COMPRESSED_MAGIC 0x5a43564e
+//payloads with fewer blocks than this are decompressed on the calling thread
+#define PARALLEL_BLOCKS 4
+
+using namespace Nova;
+
+namespace {
+    struct Block {
+        const char* data;
+        size_t size;
+        size_t offset;
+        size_t decompressedSize;
+    };
+
+    //the header is untrusted, every block has to land inside dest
+    std::vector<Block> readBlocks(const void* data, size_t size, size_t destSize, CompressedHeader& header) {
+        if (size < sizeof(CompressedHeader)) throw std::runtime_error("Compressed data too small");
+        memcpy(&header, data, sizeof(CompressedHeader));
+        if (header.magic != COMPRESSED_MAGIC) throw std::runtime_error("Data is not compressed");
+        if (header.blockSize == 0) throw std::runtime_error("Invalid block size");
+        if (header.blockCount != header.size / header.blockSize + (header.size % header.blockSize != 0 ? 1 : 0)) throw std::runtime_error("Invalid block count");
+        if (header.size > destSize) throw std::runtime_error("Destination too small");
+
+        const char* bytes = static_cast<const char*>(data);
+        size_t tableSize = header.blockCount * sizeof(uint32_t);
+        if (size < sizeof(CompressedHeader) + tableSize) throw std::runtime_error("Compressed data too small");
+
+        std::vector<Block> blocks;
+        blocks.reserve(header.blockCount);
+
+        const char* table = bytes + sizeof(CompressedHeader);
+        const char* ptr = table + tableSize;
+        const char* end = bytes + size;
+
+        for (uint32_t i = 0; i < header.blockCount; i++) {
+            uint32_t blockSize;
+            memcpy(&blockSize, table + i * sizeof(uint32_t), sizeof(uint32_t));
+            if (blockSize > static_cast<size_t>(end - ptr)) throw std::runtime_error("Compressed data truncated");
+
+            size_t offset = static_cast<size_t>(i) * header.blockSize;
+            size_t decompressedSize = std::min<size_t>(header.blockSize, header.size - offset);
+            if (offset + decompressedSize > destSize) throw std::runtime_error("Destination too small");
+
+            blocks.push_back({ ptr, blockSize, offset, decompressedSize });
+            ptr += blockSize;
+        }
+
+        return blocks;
+    }
+
+    size_t compressBound(Codec codec, size_t size) {
+        switch (codec) {
+        case Codec::Stored:
+            return size;
+#ifdef NOVA_LZ4
+        case Codec::LZ4:
+            return LZ4_compressBound(static_cast<int>(size));
+#endif
+#ifdef NOVA_ZSTD
+        case Codec::Zstd:
+            return ZSTD_compressBound(size);
+#endif
+        default:
+            throw std::runtime_error("Codec not supported");
+        }
+    }
+
+    size_t compressBlock(Codec codec, const char* src, size_t size, char* dest, [[maybe_unused]] size_t capacity) {
+        switch (codec) {
+        case Codec::Stored:
+            memcpy(dest, src, size);
+            return size;
+#ifdef NOVA_LZ4
+        case Codec::LZ4: {
+            int result = LZ4_compress_default(src, dest, static_cast<int>(size), static_cast<int>(capacity));
+            if (result <= 0) throw std::runtime_error("LZ4 compression failed");
+            return static_cast<size_t>(result);
+        }
+#endif
+#ifdef NOVA_ZSTD
+        case Codec::Zstd: {
+            size_t result = ZSTD_compress(dest, capacity, src, size, ZSTD_CLEVEL_DEFAULT);
+            if (ZSTD_isError(result)) throw std::runtime_error("Zstd compression failed");
+            return result;
+        }
+#endif
+        default:
+            throw std::runtime_error("Codec not supported");
+        }
+    }
+
+    void decompressBlock(Codec codec, const Block& block, char* dest) {
+        switch (codec) {
+        case Codec::Stored:
+            if (block.size != block.decompressedSize) throw std::runtime_error("Stored block has wrong size");
+            memcpy(dest, block.data, block.size);
+            return;
+#ifdef NOVA_LZ4
+        case Codec::LZ4: {
+            int result = LZ4_decompress_safe(block.data, dest, static_cast<int>(block.size), static_cast<int>(block.decompressedSize));
+            if (result < 0 || static_cast<size_t>(result) != block.decompressedSize) throw std::runtime_error("LZ4 decompression failed");
+            return;
+        }
+#endif
+#ifdef NOVA_ZSTD
+        case Codec::Zstd: {
+            size_t result = ZSTD_decompress(dest, block.decompressedSize, block.data, block.size);
+            if (ZSTD_isError(result) || result != block.decompressedSize) throw std::runtime_error("Zstd decompression failed");
+            return;
+        }
+#endif
+        default:
+            throw std::runtime_error("Codec not supported");
+        }
+    }
+}
+
+bool Nova::codecSupported(Codec codec) {
+    switch (codec) {
+    case Codec::Stored:
+        return true;
+#ifdef NOVA_LZ4
+    case Codec::LZ4:
+        return true;
+#endif
+#ifdef NOVA_ZSTD
+    case Codec::Zstd:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+std::vector<char> Nova::compress(Codec codec, const void* data, size_t size, size_t blockSize) {
+    if (blockSize == 0 || blockSize > UINT32_MAX) throw std::runtime_error("Invalid block size");
+
+    const char* bytes = static_cast<const char*>(data);
+
+    CompressedHeader header = {};
+    header.magic = COMPRESSED_MAGIC;
+    header.codec = codec;
+    header.size = size;
+    header.blockSize = static_cast<uint32_t>(blockSize);
+    header.blockCount = static_cast<uint32_t>((size + blockSize - 1) / blockSize);
+
+    size_t tableSize = header.blockCount * sizeof(uint32_t);
+    std::vector<char> result(sizeof(CompressedHeader) + tableSize);
+    memcpy(result.data(), &header, sizeof(CompressedHeader));
+
+    std::vector<char> scratch(compressBound(codec, blockSize));
+
+    for (uint32_t i = 0; i < header.blockCount; i++) {
+        size_t offset = static_cast<size_t>(i) * blockSize;
+        size_t length = std::min(blockSize, size - offset);
+        uint32_t compressed = static_cast<uint32_t>(compressBlock(codec, bytes + offset, length, scratch.data(), scratch.size()));
+
+        memcpy(result.data() + sizeof(CompressedHeader) + i * sizeof(uint32_t), &compressed, sizeof(uint32_t));
+        result.insert(result.end(), scratch.data(), scratch.data() + compressed);
+    }
+
+    return result;
+}
+
+size_t Nova::decompressedSize(const void* data, size_t size) {
+    if (size < sizeof(CompressedHeader)) throw std::runtime_error("Compressed data too small");
+
+    CompressedHeader header;
+    memcpy(&header, data, sizeof(CompressedHeader));
+    if (header.magic != COMPRESSED_MAGIC) throw std::runtime_error("Data is not compressed");
+
+    return static_cast<size_t>(header.size);
+}
+
+void Nova::decompress(const void* data, size_t size, void* dest, size_t destSize, bool hostCached, ThreadPool* threadPool) {
+    CompressedHeader header;
+    std::vector<Block> blocks = readBlocks(data, size, destSize, header);
+    if (!codecSupported(header.codec)) throw std::runtime_error("Codec not supported");
+
+    char* output = static_cast<char*>(dest);
+
+    auto run = [&](size_t i) {
+        const Block& block = blocks[i];
+
+        if (hostCached || header.codec == Codec::Stored) {
+            decompressBlock(header.codec, block, output + block.offset);
+        } else {
+            thread_local std::vector<char> scratch;
+            if (scratch.size() < block.decompressedSize) scratch.resize(block.decompressedSize);
+
+            decompressBlock(header.codec, block, scratch.data());
+            copyToMapped(output + block.offset, scratch.data(), block.decompressedSize, false);
+        }
+    };
+
+    if (threadPool != nullptr && blocks.size() >= PARALLEL_BLOCKS) {
+        threadPool->parallelFor(blocks.size(), run);
+    } else {
+        for (size_t i = 0; i < blocks.size(); i++) {
+            run(i);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#include "NovaEngine/ComputeNode.h"
+#include "NovaEngine/Engine.h"
+#include <functional>
+
+using namespace Nova;
+
+ComputeNode::ComputeNode(Engine& engine, FrameGraph& frameGraph) : FrameNode(engine.renderer().computeQueue(), vk::PipelineStageFlags::ComputeShader, vk::PipelineStageFlags::ComputeShader) {
+    m_engine = &engine;
+    m_frameGraph = &frameGraph;
+}
+
+void ComputeNode::queue(Dispatch dispatch, const vk::Pipeline& pipeline, const vk::PipelineLayout& layout, const std::vector<const vk::DescriptorSet*>& descriptorSets, const void* pushConstants, size_t pushSize) {
+    dispatch.pipeline = &pipeline;
+    dispatch.layout = &layout;
+    dispatch.firstSet = m_descriptorSets.size();
+    dispatch.setCount = descriptorSets.size();
+    dispatch.pushOffset = m_pushConstants.size();
+    dispatch.pushSize = pushSize;
+
+    m_descriptorSets.insert(m_descriptorSets.end(), descriptorSets.begin(), descriptorSets.end());
+
+    if (pushSize > 0) {
+        const char* data = static_cast<const char*>(pushConstants);
+        m_pushConstants.insert(m_pushConstants.end(), data, data + pushSize);
+    }
+
+    m_dispatches.push_back(dispatch);
+}
+
+void ComputeNode::dispatch(const vk::Pipeline& pipeline, const vk::PipelineLayout& layout, const std::vector<const vk::DescriptorSet*>& descriptorSets, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ, const void* pushConstants, size_t pushSize) {
+    Dispatch dispatch = {};
+    dispatch.groupCountX = groupCountX;
+    dispatch.groupCountY = groupCountY;
+    dispatch.groupCountZ = groupCountZ;
+
+    queue(dispatch, pipeline, layout, descriptorSets, pushConstants, pushSize);
+}
+
+void ComputeNode::dispatchIndirect(const vk::Pipeline& pipeline, const vk::PipelineLayout& layout, const std::vector<const vk::DescriptorSet*>& descriptorSets, const Buffer& buffer, size_t offset, const void* pushConstants, size_t pushSize) {
+    Dispatch dispatch = {};
+    dispatch.indirectBuffer = &buffer;
+    dispatch.indirectOffset = offset;
+
+    queue(dispatch, pipeline, layout, descriptorSets, pushConstants, pushSize);
+}
+
+void ComputeNode::barrier() {
+    Dispatch dispatch = {};
+    dispatch.barrier = true;
+    m_dispatches.push_back(dispatch);
+}
+
+std::vector<const vk::CommandBuffer*>& ComputeNode::submit(size_t frame, size_t index) {
+    m_commandBuffers.clear();
+
+    vk::CommandBuffer& commandBuffer = commandBuffers()[index];
+    commandBuffer.reset({});
+
+    vk::CommandBufferBeginInfo beginInfo = {};
+    beginInfo.flags = vk::CommandBufferUsageFlags::OneTimeSubmit;
+
+    commandBuffer.begin(beginInfo);
+
+    FrameNode::preRecord(commandBuffer);
+
+    for (auto& dispatch : m_dispatches) {
+        record(commandBuffer, dispatch);
+    }
+
+    FrameNode::postRecord(commandBuffer);
+
+    commandBuffer.end();
+    m_commandBuffers.push_back(&commandBuffer);
+
+    m_dispatches.clear();
+    m_descriptorSets.clear();
+    m_pushConstants.clear();
+    return m_commandBuffers;
+}
+
+void ComputeNode::skip(size_t frame) {
+    m_dispatches.clear();
+    m_descriptorSets.clear();
+    m_pushConstants.clear();
+    clearInstances();
+}
+
+void ComputeNode::record(vk::CommandBuffer& commandBuffer, const Dispatch& dispatch) {
+    if (dispatch.barrier) {
+        vk::MemoryBarrier barrier = {};
+        barrier.srcAccessMask = vk::AccessFlags::ShaderWrite;
+        barrier.dstAccessMask = vk::AccessFlags::ShaderRead | vk::AccessFlags::ShaderWrite | vk::AccessFlags::IndirectCommandRead;
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlags::ComputeShader, vk::PipelineStageFlags::ComputeShader | vk::PipelineStageFlags::DrawIndirect, {}, { barrier }, {}, {});
+        return;
+    }
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::Compute, *dispatch.pipeline);
+
+    if (dispatch.setCount > 0) {
+        std::vector<std::reference_wrapper<const vk::DescriptorSet>> sets;
+
+        for (size_t i = dispatch.firstSet; i < dispatch.firstSet + dispatch.setCount; i++) {
+            sets.push_back(*m_descriptorSets[i]);
+        }
+
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::Compute, *dispatch.layout, 0, sets, {});
+    }
+
+    if (dispatch.pushSize > 0) {
+        commandBuffer.pushConstants(*dispatch.layout, vk::ShaderStageFlags::Compute, 0, static_cast<uint32_t>(dispatch.pushSize), &m_pushConstants[dispatch.pushOffset]);
+    }
+
+    if (dispatch.indirectBuffer != nullptr) {
+        commandBuffer.dispatchIndirect(dispatch.indirectBuffer->resource(), dispatch.indirectOffset);
+    } else {
+        commandBuffer.dispatch(dispatch.groupCountX, dispatch.groupCountY, dispatch.groupCountZ);
+    }
+}
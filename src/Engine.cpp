@@ -1,4 +1,6 @@
 #include <NovaEngine/Engine.h>
+#include <NovaEngine/Trace.h>
+#include <thread>
 
 #define VIRTUAL_FRAMES 2
 
@@ -8,6 +10,11 @@ Engine::Engine(Renderer& renderer) {
     m_renderer = &renderer;
     m_memory = std::make_unique<Memory>(*this);
     m_frameGraph = std::make_unique<FrameGraph>(*this, VIRTUAL_FRAMES);
+
+    //the calling thread also takes part in parallel work, so leave a core for it
+    size_t cores = std::thread::hardware_concurrency();
+    m_threadPool = std::make_unique<ThreadPool>(cores > 1 ? cores - 1 : 1);
+    m_tasks = std::make_unique<TaskScheduler>(*this);
 }
 
 void Engine::addWindow(Window& window) {
@@ -22,19 +29,41 @@ void Engine::addSystem(ISystem& system) {
     m_systems.push_back(&system);
 }
 
+void Engine::enableFlightRecorder(size_t frames) {
+    if (m_flightRecorder != nullptr) return;
+    m_flightRecorder = std::make_unique<FlightRecorder>(*this, frames);
+}
+
 void Engine::step() {
+    NOVA_TRACE_ZONE("Engine::step");
+    NOVA_TRACE_FRAME(m_frameGraph->frame());
     m_clock.update();
+
+    if (m_flightRecorder != nullptr) {
+        m_flightRecorder->update(m_clock.deltaTime());
+    }
+
     m_memory->update(m_frameGraph->completedFrames());
 
     glfwPollEvents();
     m_window->update();
 
     if (!m_window->canRender()) {
+        //waiting for the window isn't a hitch
+        if (m_flightRecorder != nullptr) {
+            m_flightRecorder->skipFrame();
+        }
+
         glfwWaitEvents();
     } else {
         for (auto system : m_systems) {
+            NOVA_FLIGHT_ZONE(m_flightRecorder.get(), "ISystem::update");
             system->update(static_cast<float>(m_clock.deltaTime()));
         }
+        {
+            NOVA_FLIGHT_ZONE(m_flightRecorder.get(), "TaskScheduler::update");
+            m_tasks->update();
+        }
         m_frameGraph->submit();
     }
 }
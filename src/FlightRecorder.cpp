@@ -0,0 +1,189 @@
+#include "NovaEngine/FlightRecorder.h"
+#include "NovaEngine/Engine.h"
+#include "NovaEngine/Trace.h"
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+
+using namespace Nova;
+
+FlightRecorder::FlightRecorder(Engine& engine, size_t frames) {
+    m_engine = &engine;
+    setFrames(frames);
+}
+
+void FlightRecorder::setFrames(size_t frames) {
+    if (frames == 0) throw std::runtime_error("Flight recorder needs at least one frame");
+
+    m_frames.clear();
+    m_frames.resize(frames);
+
+    for (auto& frame : m_frames) {
+        frame.zones.reserve(ZoneCapacity);
+    }
+
+    m_next = 0;
+    m_count = 0;
+    m_recording = false;
+}
+
+void FlightRecorder::update(double deltaTime) {
+    if (m_recording) {
+        end(deltaTime);
+
+        //deltaTime is the length of the frame that just ended, so the spike is already in the ring
+        size_t frame = current().frame;
+
+        if (deltaTime > m_threshold && (m_dumps == 0 || frame >= m_lastDump + m_cooldown)) {
+            m_lastDump = frame;
+            dump();
+        }
+    }
+
+    begin();
+}
+
+void FlightRecorder::skipFrame() {
+    if (!m_recording) return;
+
+    m_next = (m_next + m_frames.size() - 1) % m_frames.size();
+    m_count--;
+    m_recording = false;
+}
+
+void FlightRecorder::zone(const char* name, uint64_t start, uint64_t end) {
+    if (!m_recording) return;
+
+    //the capacity was reserved, so recording never allocates
+    Frame& frame = current();
+
+    if (frame.zones.size() < ZoneCapacity) {
+        frame.zones.push_back({ name, start, end });
+    } else {
+        frame.droppedZones++;
+    }
+}
+
+void FlightRecorder::begin() {
+    Frame& frame = m_frames[m_next];
+    m_next = (m_next + 1) % m_frames.size();
+    m_count = std::min(m_count + 1, m_frames.size());
+
+    //the memory totals are kept until end turns them into the frame's share
+    const Memory::Stats& stats = m_engine->memory().stats();
+    frame.frame = m_engine->frameGraph().frame();
+    frame.start = Trace::now();
+    frame.allocations = stats.allocations;
+    frame.frees = stats.frees;
+    frame.allocatedBytes = stats.allocatedBytes;
+    frame.pages = stats.pages;
+    frame.nodes.clear();
+    frame.zones.clear();
+    frame.droppedZones = 0;
+    m_recording = true;
+}
+
+void FlightRecorder::end(double deltaTime) {
+    Frame& frame = current();
+    frame.end = Trace::now();
+    frame.deltaTime = deltaTime;
+
+    const Memory::Stats& stats = m_engine->memory().stats();
+    frame.allocations = stats.allocations - frame.allocations;
+    frame.frees = stats.frees - frame.frees;
+    frame.allocatedBytes = stats.allocatedBytes - frame.allocatedBytes;
+    frame.pages = stats.pages - frame.pages;
+
+    //only timings read back since the last frame are new, the rest were already recorded
+    GpuProfiler* profiler = m_engine->frameGraph().profiler();
+
+    if (profiler != nullptr) {
+        size_t latest = m_timingFrame;
+
+        for (auto& [node, timing] : profiler->timings()) {
+            if (timing.frame() <= m_timingFrame) continue;
+
+            frame.nodes.push_back({ node, timing.frame(), timing.last() });
+            latest = std::max(latest, timing.frame());
+        }
+
+        m_timingFrame = latest;
+    }
+
+    m_recording = false;
+}
+
+void FlightRecorder::dump() {
+    //formatting has to read the rings now, only the file is written on a worker so the next frame isn't held up further
+    std::ostringstream stream;
+    write(stream);
+
+    std::string path = m_path + "_" + std::to_string(current().frame) + ".json";
+    std::string contents = stream.str();
+    m_dumps++;
+
+    m_engine->threadPool().enqueue([path, contents]() {
+        std::ofstream file(path, std::ios::binary);
+        file << contents;
+    });
+}
+
+void FlightRecorder::write(std::ostream& stream) const {
+    //the frame being recorded is left out until it ends
+    size_t size = m_frames.size();
+    size_t count = m_recording ? m_count - 1 : m_count;
+    size_t oldest = (m_next + size - m_count) % size;
+
+    stream << "{\"traceEvents\":[";
+    Trace::writeEvents(stream, count > 0 ? m_frames[oldest].start : 0);
+    stream << ",{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"Frames\"}}";
+
+    //node samples are kept by the frame that read them back and shown under the frame that submitted the work
+    //removed nodes are no longer in the profiler, so their samples are left out
+    const GpuProfiler* profiler = m_engine->frameGraph().profiler();
+
+    for (size_t i = 0; i < count; i++) {
+        const Frame& frame = m_frames[(oldest + i) % size];
+
+        stream << ",{\"name\":\"Frame " << frame.frame << "\",\"ph\":\"X\",\"pid\":2,\"tid\":0,\"ts\":";
+        Trace::writeTime(stream, frame.start);
+        stream << ",\"dur\":";
+        Trace::writeTime(stream, frame.end - frame.start);
+        stream << ",\"args\":{\"deltaTime\":" << frame.deltaTime * 1000;
+        stream << ",\"allocations\":" << frame.allocations << ",\"frees\":" << frame.frees;
+        stream << ",\"allocatedBytes\":" << frame.allocatedBytes << ",\"pages\":" << frame.pages;
+        stream << ",\"droppedZones\":" << frame.droppedZones;
+        stream << ",\"gpu\":{";
+
+        bool first = true;
+
+        for (size_t j = 0; j < count && profiler != nullptr; j++) {
+            for (auto& sample : m_frames[(oldest + j) % size].nodes) {
+                if (sample.frame != frame.frame || profiler->timings().count(sample.node) == 0) continue;
+
+                if (!first) stream << ",";
+                first = false;
+
+                Trace::writeString(stream, sample.node->name().size() > 0 ? sample.node->name() : "FrameNode");
+                stream << ":" << sample.duration;
+            }
+        }
+
+        stream << "}}}";
+    }
+
+    stream << ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":1,\"args\":{\"name\":\"Zones\"}}";
+
+    for (size_t i = 0; i < count; i++) {
+        for (auto& zone : m_frames[(oldest + i) % size].zones) {
+            //zone names are string literals, they are not escaped
+            stream << ",{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":2,\"tid\":1,\"ts\":";
+            Trace::writeTime(stream, zone.start);
+            stream << ",\"dur\":";
+            Trace::writeTime(stream, zone.end - zone.start);
+            stream << "}";
+        }
+    }
+
+    stream << "]}";
+}
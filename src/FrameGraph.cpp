@@ -1,6 +1,9 @@
 #include "NovaEngine/FrameGraph.h"
 #include "NovaEngine/DirectedAcyclicGraph.h"
 #include "NovaEngine/Engine.h"
+#include "NovaEngine/Trace.h"
+#include <algorithm>
+#include <functional>
 
 using namespace Nova;
 
@@ -11,10 +14,11 @@ BufferUsage::BufferUsage(FrameNode* node, vk::PipelineStageFlags stageMask, vk::
 }
 
 void BufferUsage::add(const Buffer& buffer, size_t offset, size_t size) {
-    if (!m_node->addBuffer(buffer.resource(), { &buffer.resource(), offset, size, this })) {
-        if (m_node->m_bufferMap[&buffer.resource()].usage == this) return;
-        throw std::runtime_error("Buffer already used by this RenderNode");
-    }
+    m_node->m_buffers.push_back({ &buffer.resource(), offset, size, this });
+}
+
+void BufferUsage::declare(const Buffer& buffer, size_t offset, size_t size) {
+    m_node->m_declaredBuffers.push_back({ &buffer.resource(), offset, size, this });
 }
 
 ImageUsage::ImageUsage(FrameNode* node, vk::PipelineStageFlags stageMask, vk::AccessFlags accessMask, vk::ImageLayout layout) {
@@ -25,10 +29,11 @@ ImageUsage::ImageUsage(FrameNode* node, vk::PipelineStageFlags stageMask, vk::Ac
 }
 
 void ImageUsage::add(const Image& image, vk::ImageSubresourceRange range) {
-    if (!m_node->addImage(image.resource(), { &image.resource(), range, this })) {
-        if (m_node->m_imageMap[&image.resource()].usage == this) return;
-        throw std::runtime_error("Image already used by this RenderNode");
-    }
+    m_node->m_images.push_back({ &image.resource(), range, this });
+}
+
+void ImageUsage::declare(const Image& image, vk::ImageSubresourceRange range) {
+    m_node->m_declaredImages.push_back({ &image.resource(), range, this });
 }
 
 FrameNode::FrameNode(const vk::Queue& queue, vk::PipelineStageFlags sourceStages, vk::PipelineStageFlags destStages) {
@@ -37,11 +42,6 @@ FrameNode::FrameNode(const vk::Queue& queue, vk::PipelineStageFlags sourceStages
     m_sourceStages = sourceStages;
     m_destStages = destStages;
 
-    m_selfSync = std::make_unique<vk::Semaphore>(m_queue->device(), vk::SemaphoreCreateInfo{});
-    m_submitInfo.signalSemaphores.push_back(*m_selfSync);
-    m_submitInfo.waitSemaphores.push_back(*m_selfSync);
-    m_submitInfo.waitDstStageMask.push_back(m_sourceStages);
-
     createCommandPool();
 }
 
@@ -71,181 +71,514 @@ ImageUsage& FrameNode::addImageUsage(vk::PipelineStageFlags stageMask, vk::Acces
     return *m_imageUsages.back();
 }
 
-bool FrameNode::addBuffer(vk::Buffer& buffer, BufferUsage::Instance usage) {
-    return m_bufferMap.insert({ &buffer, usage }).second;
-}
+void FrameNode::compileInstances() {
+    NOVA_TRACE_ZONE("FrameNode::compileInstances");
+    m_buffers.insert(m_buffers.end(), m_declaredBuffers.begin(), m_declaredBuffers.end());
+    m_images.insert(m_images.end(), m_declaredImages.begin(), m_declaredImages.end());
 
-bool FrameNode::addImage(vk::Image& image, ImageUsage::Instance usage) {
-    return m_imageMap.insert({ &image, usage }).second;
+    std::sort(m_buffers.begin(), m_buffers.end(), [](const BufferUsage::Instance& a, const BufferUsage::Instance& b) {
+        return std::less<vk::Buffer*>()(a.buffer, b.buffer);
+    });
+
+    std::sort(m_images.begin(), m_images.end(), [](const ImageUsage::Instance& a, const ImageUsage::Instance& b) {
+        return std::less<vk::Image*>()(a.image, b.image);
+    });
+
+    //a resource added more than once is grown to cover every range
+    size_t count = 0;
+    for (size_t i = 0; i < m_buffers.size(); i++) {
+        auto& instance = m_buffers[i];
+
+        if (count > 0 && m_buffers[count - 1].buffer == instance.buffer) {
+            auto& current = m_buffers[count - 1];
+            if (current.usage != instance.usage) throw std::runtime_error("Buffer already used by this RenderNode");
+
+            if (current.size == VK_WHOLE_SIZE || instance.size == VK_WHOLE_SIZE) {
+                current.offset = std::min(current.offset, instance.offset);
+                current.size = VK_WHOLE_SIZE;
+            } else {
+                size_t end = std::max(current.offset + current.size, instance.offset + instance.size);
+                current.offset = std::min(current.offset, instance.offset);
+                current.size = end - current.offset;
+            }
+        } else {
+            m_buffers[count++] = instance;
+        }
+    }
+    m_buffers.resize(count);
+
+    count = 0;
+    for (size_t i = 0; i < m_images.size(); i++) {
+        auto& instance = m_images[i];
+
+        if (count > 0 && m_images[count - 1].image == instance.image) {
+            auto& current = m_images[count - 1];
+            if (current.usage != instance.usage) throw std::runtime_error("Image already used by this RenderNode");
+
+            vk::ImageSubresourceRange& range = current.range;
+            uint32_t levelEnd = std::max(range.baseMipLevel + range.levelCount, instance.range.baseMipLevel + instance.range.levelCount);
+            uint32_t layerEnd = std::max(range.baseArrayLayer + range.layerCount, instance.range.baseArrayLayer + instance.range.layerCount);
+            range.aspectMask |= instance.range.aspectMask;
+            range.baseMipLevel = std::min(range.baseMipLevel, instance.range.baseMipLevel);
+            range.levelCount = levelEnd - range.baseMipLevel;
+            range.baseArrayLayer = std::min(range.baseArrayLayer, instance.range.baseArrayLayer);
+            range.layerCount = layerEnd - range.baseArrayLayer;
+        } else {
+            m_images[count++] = instance;
+        }
+    }
+    m_images.resize(count);
 }
 
 void FrameNode::clearInstances() {
-    m_bufferMap.clear();
-    m_imageMap.clear();
+    m_buffers.clear();
+    m_images.clear();
+}
+
+void FrameNode::compileSubmit(uint64_t waitMask) {
+    auto& timelines = m_graph->m_timelines;
+
+    //external semaphores are binary, their values are ignored
+    vk::SubmitInfo& info = m_frameSubmitInfo;
+    info = m_submitInfo;
+    m_waitValues.assign(info.waitSemaphores.size(), 0);
+    m_signalValues.assign(info.signalSemaphores.size(), 0);
+    m_externalWaits = m_waitValues.size();
+
+    for (size_t i = 0; i < timelines.size(); i++) {
+        if ((waitMask & (uint64_t(1) << i)) == 0) continue;
+
+        info.waitSemaphores.push_back(*timelines[i].semaphore);
+        info.waitDstStageMask.push_back(m_sourceStages);
+        m_waitValues.push_back(0);
+    }
+
+    info.signalSemaphores.push_back(*timelines[m_timeline].semaphore);
+    m_signalValues.push_back(0);
+
+    m_waitMask = waitMask;
+    m_submitDirty = false;
 }
 
-void FrameNode::submit(size_t frame, size_t index, vk::Fence& fence) {
-    m_submitInfo.commandBuffers.clear();
-    auto commandBuffers = submit(frame, index);
+const vk::SubmitInfo& FrameNode::buildSubmit(const std::vector<uint64_t>& waits) {
+    //waits holds the value needed from each timeline, zero where the node doesn't wait
+    uint64_t waitMask = 0;
+
+    for (size_t i = 0; i < waits.size(); i++) {
+        if (waits[i] > 0) waitMask |= uint64_t(1) << i;
+    }
 
-    for (auto commandBuffer : commandBuffers) {
-        m_submitInfo.commandBuffers.push_back(*commandBuffer);
+    if (m_submitDirty || waitMask != m_waitMask) {
+        compileSubmit(waitMask);
     }
 
-    m_queue->submit({ m_submitInfo }, &fence);
+    //only the timeline values and command buffers change from frame to frame
+    vk::SubmitInfo& info = m_frameSubmitInfo;
+    size_t wait = m_externalWaits;
+
+    for (size_t i = 0; i < waits.size(); i++) {
+        if (waits[i] > 0) m_waitValues[wait++] = waits[i];
+    }
+
+    m_signalValues.back() = m_timelineValue;
+
+    info.commandBuffers.clear();
+    for (auto commandBuffer : *m_recorded) {
+        info.commandBuffers.push_back(*commandBuffer);
+    }
+
+    //kept in the node, so the pointers stay valid until the FrameGraph submits the batch
+    m_timelineInfo = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR };
+    m_timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(m_waitValues.size());
+    m_timelineInfo.pWaitSemaphoreValues = m_waitValues.data();
+    m_timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(m_signalValues.size());
+    m_timelineInfo.pSignalSemaphoreValues = m_signalValues.data();
+    info.next = &m_timelineInfo;
+
+    return info;
 }
 
 void FrameNode::addExternalWait(vk::Semaphore& semaphore, vk::PipelineStageFlags stageMask) {
     m_submitInfo.waitSemaphores.push_back(semaphore);
     m_submitInfo.waitDstStageMask.push_back(stageMask);
+    m_submitDirty = true;
 }
 
 void FrameNode::addExternalSignal(vk::Semaphore& semaphore) {
     m_submitInfo.signalSemaphores.push_back(semaphore);
+    m_submitDirty = true;
 }
 
-void FrameNode::preRecord(vk::CommandBuffer& commandBuffer) {
+FrameGraph::Edge* FrameNode::eventEdge(const void* resource) {
+    auto& lastAccess = m_graph->m_lastAccess;
+    auto it = lastAccess.find(resource);
+    if (it == lastAccess.end() || it->second == this) return nullptr;
+
     for (auto event : m_inEvents) {
-        event->recordDest(commandBuffer);
+        if (event->source == it->second && event->events.size() > 0) return event;
     }
+
+    return nullptr;
 }
 
-void FrameNode::postRecord(vk::CommandBuffer& commandBuffer) {
-    for (auto event : m_outEvents) {
-        event->recordSource(commandBuffer);
+void FrameNode::planBarriers() {
+    NOVA_TRACE_ZONE("FrameNode::planBarriers");
+    ResourceStateTracker& tracker = m_graph->m_resourceStates;
+    auto& lastAccess = m_graph->m_lastAccess;
+    m_preBarriers.clear();
+    m_postBarriers.clear();
+
+    for (auto event : m_inEvents) {
+        event->waitBarriers.clear();
     }
-}
 
-FrameGraph::Edge::Edge(FrameNode& source, FrameNode& dest) {
-    this->source = &source;
-    this->dest = &dest;
+    //barriers for resources last accessed by a source on this queue are recorded with the wait on its event
+    for (auto& instance : m_buffers) {
+        BufferUsage& usage = *instance.usage;
+        FrameGraph::Edge* edge = eventEdge(instance.buffer);
+        auto& barriers = edge != nullptr ? edge->waitBarriers.buffers : m_preBarriers.buffers;
 
-    if (source.m_family == dest.m_family) {
-        vk::EventCreateInfo info = {};
+        //reached from its last user on another family through nodes that don't share it, so no edge released it
+        auto last = lastAccess.find(instance.buffer);
+        if (last != lastAccess.end() && last->second->m_family != m_family && !tracker.owned(*instance.buffer, m_family)) {
+            tracker.release(*instance.buffer, last->second->m_family, m_family, last->second->m_postBarriers.buffers);
+        }
 
-        event = std::make_unique<vk::Event>(source.m_queue->device(), info);
-    } else {
-        vk::SemaphoreCreateInfo info = {};
+        tracker.use(*instance.buffer, { usage.m_stageMask, usage.m_accessMask, vk::ImageLayout::Undefined, m_family }, barriers);
+        lastAccess[instance.buffer] = this;
+    }
 
-        semaphore = std::make_unique<vk::Semaphore>(source.m_queue->device(), info);
+    for (auto& instance : m_images) {
+        ImageUsage& usage = *instance.usage;
+        FrameGraph::Edge* edge = eventEdge(instance.image);
+        auto& barriers = edge != nullptr ? edge->waitBarriers.images : m_preBarriers.images;
+
+        auto last = lastAccess.find(instance.image);
+        if (last != lastAccess.end() && last->second->m_family != m_family && !tracker.owned(*instance.image, instance.range, m_family)) {
+            tracker.release(*instance.image, instance.range, last->second->m_family, m_family, usage.m_layout, last->second->m_postBarriers.images);
+        }
 
-        source.m_submitInfo.signalSemaphores.push_back(*semaphore);
-        dest.m_submitInfo.waitSemaphores.push_back(*semaphore);
-        dest.m_submitInfo.waitDstStageMask.push_back(source.m_destStages);
+        tracker.use(*instance.image, instance.range, { usage.m_stageMask, usage.m_accessMask, usage.m_layout, m_family }, barriers);
+        lastAccess[instance.image] = this;
     }
-}
 
-void FrameGraph::Edge::buildBarriers() {
-    sourceBufferBarriers.clear();
-    sourceImageBarriers.clear();
-    destBufferBarriers.clear();
-    destImageBarriers.clear();
+    size_t index = m_graph->m_frame % m_graph->m_frameCount;
 
-    for (auto& sourceInstance : source->m_bufferMap) {
-        auto destInstance = dest->m_bufferMap.find(sourceInstance.first);
-        if (destInstance != dest->m_bufferMap.end()) {
-            vk::BufferMemoryBarrier sourceBarrier = {};
-            sourceBarrier.buffer = sourceInstance.first;
-            sourceBarrier.offset = sourceInstance.second.offset;
-            sourceBarrier.size = sourceInstance.second.size;
-            sourceBarrier.srcQueueFamilyIndex = source->m_family;
-            sourceBarrier.dstQueueFamilyIndex = dest->m_family;
-            sourceBarrier.srcAccessMask = sourceInstance.second.usage->m_accessMask;
+    for (auto event : m_inEvents) {
+        FrameGraph::BarrierBatch& batch = event->waitBarriers;
+        if (batch.buffers.size() == 0 && batch.images.size() == 0) continue;
 
-            if (event != nullptr) {
-                sourceBarrier.dstAccessMask = destInstance->second.usage->m_accessMask;
-            }
+        //vkCmdWaitEvents takes the union of the stages its events were set with, so both sides use the same stages
+        event->eventStages = {};
+        for (auto& info : batch.buffers) {
+            event->eventStages |= info.source;
+        }
+        for (auto& info : batch.images) {
+            event->eventStages |= info.source;
+        }
 
-            sourceBufferBarriers.push_back({ sourceBarrier, sourceInstance.second.usage->m_stageMask, destInstance->second.usage->m_stageMask });
+        event->event = event->events[index].get();
+        event->signaled[index] = true;
+    }
 
-            if (event != nullptr) {
-                vk::BufferMemoryBarrier destBarrier = {};
-                destBarrier.buffer = destInstance->first;
-                destBarrier.offset = destInstance->second.offset;
-                destBarrier.size = destInstance->second.size;
-                destBarrier.srcQueueFamilyIndex = source->m_family;
-                destBarrier.dstQueueFamilyIndex = dest->m_family;
-                destBarrier.srcAccessMask = sourceInstance.second.usage->m_accessMask;
-                destBarrier.dstAccessMask = destInstance->second.usage->m_accessMask;
+    planResources(tracker);
 
-                destBufferBarriers.push_back({ destBarrier, sourceInstance.second.usage->m_stageMask, destInstance->second.usage->m_stageMask });
-            }
+    //a skipped destination never acquires, so its releases go to the first active consumers after it
+    for (auto event : m_outEvents) {
+        if (event->dest->m_active) {
+            event->addReleases(tracker, m_postBarriers);
         }
     }
 
-    for (auto& sourceInstance : source->m_imageMap) {
-        auto destInstance = dest->m_imageMap.find(sourceInstance.first);
-        if (destInstance != dest->m_imageMap.end()) {
-            vk::ImageMemoryBarrier sourceBarrier = {};
-            sourceBarrier.image = sourceInstance.first;
-            sourceBarrier.subresourceRange = sourceInstance.second.range;
-            sourceBarrier.srcQueueFamilyIndex = source->m_family;
-            sourceBarrier.dstQueueFamilyIndex = dest->m_family;
-            sourceBarrier.srcAccessMask = sourceInstance.second.usage->m_accessMask;
+    forwardReleases(tracker);
+}
 
-            if (event != nullptr) {
-                sourceBarrier.oldLayout = sourceInstance.second.usage->m_layout;    //transition only once if on the same family
-                sourceBarrier.newLayout = sourceInstance.second.usage->m_layout;    //so don't transition with this barrier
-                sourceBarrier.dstAccessMask = destInstance->second.usage->m_accessMask;
-            } else {
-                sourceBarrier.oldLayout = sourceInstance.second.usage->m_layout;
-                sourceBarrier.newLayout = destInstance->second.usage->m_layout;
+void FrameNode::forwardReleases(ResourceStateTracker& tracker) {
+    std::vector<FrameNode*> pending;
+    std::vector<FrameNode*> visited;
+    std::vector<FrameNode*> consumers;
+
+    for (auto event : m_outEvents) {
+        if (!event->dest->m_active) pending.push_back(event->dest);
+    }
+
+    while (pending.size() > 0) {
+        FrameNode* node = pending.back();
+        pending.pop_back();
+
+        if (std::find(visited.begin(), visited.end(), node) != visited.end()) continue;
+        visited.push_back(node);
+
+        for (auto event : node->m_outEvents) {
+            FrameNode* dest = event->dest;
+
+            if (!dest->m_active) {
+                pending.push_back(dest);
+                continue;
             }
-            
-            sourceImageBarriers.push_back({ sourceBarrier, sourceInstance.second.usage->m_stageMask, destInstance->second.usage->m_stageMask });
-
-            if (event != nullptr) {
-                vk::ImageMemoryBarrier destBarrier = {};
-                destBarrier.image = destInstance->first;
-                destBarrier.subresourceRange = destInstance->second.range;
-                destBarrier.oldLayout = sourceInstance.second.usage->m_layout;
-                destBarrier.newLayout = destInstance->second.usage->m_layout;
-                destBarrier.srcQueueFamilyIndex = source->m_family;
-                destBarrier.dstQueueFamilyIndex = dest->m_family;
-                destBarrier.srcAccessMask = sourceInstance.second.usage->m_accessMask;
-                destBarrier.dstAccessMask = destInstance->second.usage->m_accessMask;
-
-                destImageBarriers.push_back({ destBarrier, sourceInstance.second.usage->m_stageMask, destInstance->second.usage->m_stageMask });
+
+            //consumers with their own edge from this node already get its releases
+            bool direct = std::find_if(m_outEvents.begin(), m_outEvents.end(), [dest](FrameGraph::Edge* edge) { return edge->dest == dest; }) != m_outEvents.end();
+
+            if (!direct && std::find(consumers.begin(), consumers.end(), dest) == consumers.end()) {
+                consumers.push_back(dest);
             }
         }
     }
+
+    //only built in frames with skipped nodes
+    for (auto consumer : consumers) {
+        FrameGraph::Edge edge(*this, *consumer);
+        edge.buildReleases();
+        edge.addReleases(tracker, m_postBarriers);
+    }
 }
 
-void FrameGraph::Edge::recordSource(vk::CommandBuffer& commandBuffer) {
-    if (event != nullptr) {
-        for (auto& barrier : sourceBufferBarriers) {
-            commandBuffer.pipelineBarrier(barrier.source, barrier.dest, {}, {}, { barrier.barrier }, {});
-        }
-        for (auto& barrier : sourceImageBarriers) {
-            commandBuffer.pipelineBarrier(barrier.source, barrier.dest, {}, {}, {},  { barrier.barrier });
+void FrameNode::preRecord(vk::CommandBuffer& commandBuffer) {
+    if (m_query != GpuProfiler::NoQuery) {
+        m_graph->m_profiler->writeTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_query);
+    }
+
+    m_preBarriers.record(commandBuffer, m_graph->m_engine->renderer());
+
+    if (!defersEventWaits()) {
+        recordEventWaits(commandBuffer);
+    }
+}
+
+void FrameNode::postRecord(vk::CommandBuffer& commandBuffer) {
+    m_postBarriers.record(commandBuffer, m_graph->m_engine->renderer());
+
+    for (auto event : m_outEvents) {
+        if (event->event != nullptr) {
+            commandBuffer.setEvent(*event->event, event->eventStages);
         }
-        commandBuffer.setEvent(*event, source->m_destStages);
-    } else {
-        for (auto& barrier : sourceBufferBarriers) {
-            commandBuffer.pipelineBarrier(barrier.source, vk::PipelineStageFlags::BottomOfPipe, {}, {}, { barrier.barrier }, {});
+    }
+
+    if (m_query != GpuProfiler::NoQuery) {
+        m_graph->m_profiler->writeTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_query + 1);
+    }
+}
+
+void FrameNode::recordEventWaits(vk::CommandBuffer& commandBuffer) {
+    std::vector<std::reference_wrapper<const vk::Event>> events;
+    vk::PipelineStageFlags source = {};
+    vk::PipelineStageFlags dest = {};
+    std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+    std::vector<vk::ImageMemoryBarrier> imageBarriers;
+
+    for (auto event : m_inEvents) {
+        if (event->event == nullptr) continue;
+
+        events.push_back(*event->event);
+        source |= event->eventStages;
+
+        for (auto& info : event->waitBarriers.buffers) {
+            dest |= info.dest;
+            bufferBarriers.push_back(info.barrier);
         }
-        for (auto& barrier : sourceImageBarriers) {
-            commandBuffer.pipelineBarrier(barrier.source, vk::PipelineStageFlags::BottomOfPipe, {}, {}, {}, { barrier.barrier });
+
+        for (auto& info : event->waitBarriers.images) {
+            dest |= info.dest;
+            imageBarriers.push_back(info.barrier);
         }
     }
+
+    if (events.size() == 0) return;
+
+    commandBuffer.waitEvents(events, source, dest, {}, bufferBarriers, imageBarriers);
+}
+
+std::vector<vk::CommandBuffer>& FrameNode::recordSecondary(size_t index, size_t count, const vk::CommandBufferBeginInfo& beginInfo, const std::function<void(vk::CommandBuffer& commandBuffer, size_t slot)>& record) {
+    if (m_secondaryBuffers.size() <= index) {
+        m_secondaryBuffers.resize(index + 1);
+    }
+
+    //command pools can't be used from several threads at once, so each slot gets its own
+    std::vector<vk::CommandBuffer>& buffers = m_secondaryBuffers[index];
+
+    for (size_t i = m_secondaryPools.size(); i < count; i++) {
+        vk::CommandPoolCreateInfo info = {};
+        info.queueFamilyIndex = m_family;
+        info.flags = vk::CommandPoolCreateFlags::ResetCommandBuffer;
+
+        m_secondaryPools.emplace_back(std::make_unique<vk::CommandPool>(m_queue->device(), info));
+    }
+
+    for (size_t i = buffers.size(); i < count; i++) {
+        vk::CommandBufferAllocateInfo info = {};
+        info.commandPool = m_secondaryPools[i].get();
+        info.level = vk::CommandBufferLevel::Secondary;
+        info.commandBufferCount = 1;
+
+        buffers.emplace_back(std::move(m_secondaryPools[i]->allocate(info)[0]));
+    }
+
+    m_graph->m_engine->threadPool().parallelFor(count, [&](size_t slot) {
+        vk::CommandBuffer& commandBuffer = buffers[slot];
+        commandBuffer.reset({});
+        commandBuffer.begin(beginInfo);
+        record(commandBuffer, slot);
+        commandBuffer.end();
+    });
+
+    return buffers;
+}
+
+FrameGraph::Edge::Edge(FrameNode& source, FrameNode& dest) {
+    this->source = &source;
+    this->dest = &dest;
 }
 
-void FrameGraph::Edge::recordDest(vk::CommandBuffer& commandBuffer) {
-    if (event != nullptr) {
-        for (auto& barrier : destBufferBarriers) {
-            commandBuffer.pipelineBarrier(barrier.source, barrier.dest, {}, {}, { barrier.barrier }, {});
+void FrameGraph::Edge::buildReleases() {
+    if (source->m_family == dest->m_family) return;
+    NOVA_TRACE_ZONE("Edge::buildReleases");
+
+    //rebuilt every frame, the merge over both sorted instance lists costs no more than checking whether they changed
+    bufferReleases.clear();
+    imageReleases.clear();
+
+    auto& sourceBuffers = source->m_buffers;
+    auto& destBuffers = dest->m_buffers;
+
+    for (size_t i = 0, j = 0; i < sourceBuffers.size() && j < destBuffers.size();) {
+        if (std::less<vk::Buffer*>()(sourceBuffers[i].buffer, destBuffers[j].buffer)) {
+            i++;
+        } else if (std::less<vk::Buffer*>()(destBuffers[j].buffer, sourceBuffers[i].buffer)) {
+            j++;
+        } else {
+            auto& sourceInstance = sourceBuffers[i++];
+            j++;
+
+            bufferReleases.push_back({ sourceInstance.buffer });
         }
-        for (auto& barrier : destImageBarriers) {
-            commandBuffer.pipelineBarrier(barrier.source, barrier.dest, {}, {}, {}, { barrier.barrier });
+    }
+
+    auto& sourceImages = source->m_images;
+    auto& destImages = dest->m_images;
+
+    for (size_t i = 0, j = 0; i < sourceImages.size() && j < destImages.size();) {
+        if (std::less<vk::Image*>()(sourceImages[i].image, destImages[j].image)) {
+            i++;
+        } else if (std::less<vk::Image*>()(destImages[j].image, sourceImages[i].image)) {
+            j++;
+        } else {
+            auto& sourceInstance = sourceImages[i++];
+            auto& destInstance = destImages[j++];
+
+            //the release and acquire must transition to the same layout, so the destination layout is used on both sides
+            imageReleases.push_back({ sourceInstance.image, sourceInstance.range, destInstance.usage->m_layout });
         }
-    } else {
-        for (auto& barrier : destBufferBarriers) {
-            commandBuffer.pipelineBarrier(vk::PipelineStageFlags::TopOfPipe, barrier.dest, {}, {}, { barrier.barrier }, {});
+    }
+}
+
+void FrameGraph::Edge::createEvents(size_t frames) {
+    events.clear();
+    signaled.assign(frames, false);
+    event = nullptr;
+
+    //events can only be waited on from the queue that set them
+    if (source->m_queue != dest->m_queue) return;
+
+    for (size_t i = 0; i < frames; i++) {
+        vk::EventCreateInfo info = {};
+        events.emplace_back(std::make_unique<vk::Event>(source->m_queue->device(), info));
+    }
+}
+
+void FrameGraph::Edge::resetEvent(const vk::Device& device, size_t index) {
+    if (events.size() == 0 || !signaled[index]) return;
+
+    vkResetEvent(device.handle(), events[index]->handle());
+    signaled[index] = false;
+}
+
+void FrameGraph::Edge::addReleases(ResourceStateTracker& tracker, BarrierBatch& batch) {
+    for (auto& release : bufferReleases) {
+        tracker.release(*release.buffer, source->m_family, dest->m_family, batch.buffers);
+    }
+    for (auto& release : imageReleases) {
+        tracker.release(*release.image, release.range, source->m_family, dest->m_family, release.layout, batch.images);
+    }
+}
+
+void FrameGraph::BarrierBatch::record(vk::CommandBuffer& commandBuffer, const Renderer& renderer) {
+    if (buffers.size() == 0 && images.size() == 0) return;
+
+#ifdef VK_KHR_synchronization2
+    if (renderer.synchronization2()) {
+        std::vector<VkBufferMemoryBarrier2KHR> bufferBarriers;
+        std::vector<VkImageMemoryBarrier2KHR> imageBarriers;
+        bufferBarriers.reserve(buffers.size());
+        imageBarriers.reserve(images.size());
+
+        for (auto& info : buffers) {
+            VkBufferMemoryBarrier2KHR barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR };
+            barrier.srcStageMask = static_cast<VkPipelineStageFlags2KHR>(info.source);
+            barrier.srcAccessMask = static_cast<VkAccessFlags2KHR>(info.barrier.srcAccessMask);
+            barrier.dstStageMask = static_cast<VkPipelineStageFlags2KHR>(info.dest);
+            barrier.dstAccessMask = static_cast<VkAccessFlags2KHR>(info.barrier.dstAccessMask);
+            barrier.srcQueueFamilyIndex = info.barrier.srcQueueFamilyIndex;
+            barrier.dstQueueFamilyIndex = info.barrier.dstQueueFamilyIndex;
+            barrier.buffer = info.barrier.buffer->handle();
+            barrier.offset = info.barrier.offset;
+            barrier.size = info.barrier.size;
+            bufferBarriers.push_back(barrier);
         }
-        for (auto& barrier : destImageBarriers) {
-            commandBuffer.pipelineBarrier(vk::PipelineStageFlags::TopOfPipe, barrier.dest, {}, {}, {}, { barrier.barrier });
+
+        for (auto& info : images) {
+            const vk::ImageSubresourceRange& range = info.barrier.subresourceRange;
+
+            VkImageMemoryBarrier2KHR barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR };
+            barrier.srcStageMask = static_cast<VkPipelineStageFlags2KHR>(info.source);
+            barrier.srcAccessMask = static_cast<VkAccessFlags2KHR>(info.barrier.srcAccessMask);
+            barrier.dstStageMask = static_cast<VkPipelineStageFlags2KHR>(info.dest);
+            barrier.dstAccessMask = static_cast<VkAccessFlags2KHR>(info.barrier.dstAccessMask);
+            barrier.oldLayout = static_cast<VkImageLayout>(info.barrier.oldLayout);
+            barrier.newLayout = static_cast<VkImageLayout>(info.barrier.newLayout);
+            barrier.srcQueueFamilyIndex = info.barrier.srcQueueFamilyIndex;
+            barrier.dstQueueFamilyIndex = info.barrier.dstQueueFamilyIndex;
+            barrier.image = info.barrier.image->handle();
+            barrier.subresourceRange = { static_cast<VkImageAspectFlags>(range.aspectMask), range.baseMipLevel, range.levelCount, range.baseArrayLayer, range.layerCount };
+            imageBarriers.push_back(barrier);
         }
+
+        VkDependencyInfoKHR dependency = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR };
+        dependency.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+        dependency.pBufferMemoryBarriers = bufferBarriers.data();
+        dependency.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+        dependency.pImageMemoryBarriers = imageBarriers.data();
+
+        renderer.cmdPipelineBarrier2()(commandBuffer.handle(), &dependency);
+        return;
+    }
+#endif
+
+    vk::PipelineStageFlags source = {};
+    vk::PipelineStageFlags dest = {};
+    std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+    std::vector<vk::ImageMemoryBarrier> imageBarriers;
+    bufferBarriers.reserve(buffers.size());
+    imageBarriers.reserve(images.size());
+
+    for (auto& info : buffers) {
+        source |= info.source;
+        dest |= info.dest;
+        bufferBarriers.push_back(info.barrier);
+    }
+
+    for (auto& info : images) {
+        source |= info.source;
+        dest |= info.dest;
+        imageBarriers.push_back(info.barrier);
     }
+
+    commandBuffer.pipelineBarrier(source, dest, {}, {}, bufferBarriers, imageBarriers);
+}
+
+void FrameGraph::BarrierBatch::clear() {
+    buffers.clear();
+    images.clear();
 }
 
 FrameGraph::FrameGraph(Engine& engine, size_t frameCount) {
@@ -265,42 +598,165 @@ void FrameGraph::addEdge(FrameNode& source, FrameNode& dest) {
     dest.m_inEvents.push_back(&event);
 }
 
+void FrameGraph::removeNode(FrameNode& node) {
+    //only the node and its neighbours use the node's command buffers and the events of its edges
+    std::vector<uint64_t> values(m_timelines.size());
+
+    auto waitFor = [&](const FrameNode* affected) {
+        if (affected->m_timelineValue == 0) return;
+        values[affected->m_timeline] = std::max(values[affected->m_timeline], affected->m_timelineValue);
+    };
+
+    waitFor(&node);
+
+    for (auto event : node.m_inEvents) {
+        waitFor(event->source);
+    }
+
+    for (auto event : node.m_outEvents) {
+        waitFor(event->dest);
+    }
+
+    wait(values);
+
+    for (auto event : node.m_inEvents) {
+        auto& outEvents = event->source->m_outEvents;
+        outEvents.erase(std::remove(outEvents.begin(), outEvents.end(), event), outEvents.end());
+    }
+
+    for (auto event : node.m_outEvents) {
+        auto& inEvents = event->dest->m_inEvents;
+        inEvents.erase(std::remove(inEvents.begin(), inEvents.end(), event), inEvents.end());
+    }
+
+    node.m_inEvents.clear();
+    node.m_outEvents.clear();
+
+    m_edges.erase(std::remove_if(m_edges.begin(), m_edges.end(), [&node](const std::unique_ptr<Edge>& edge) {
+        return edge->source == &node || edge->dest == &node;
+    }), m_edges.end());
+
+    m_nodes.erase(std::remove(m_nodes.begin(), m_nodes.end(), &node), m_nodes.end());
+
+    if (m_profiler != nullptr) {
+        m_profiler->forget(node);
+    }
+
+    //removing a node keeps the remaining order topological
+    std::vector<FrameNode*> order = m_plan.nodes;
+    order.erase(std::remove(order.begin(), order.end(), &node), order.end());
+    compile(std::move(order));
+}
+
+void FrameGraph::enableProfiling() {
+    if (m_profiler != nullptr) return;
+    m_profiler = std::make_unique<GpuProfiler>(m_engine->renderer(), m_frameCount);
+}
+
+void FrameGraph::setFrameCount(size_t frames) {
+    if (frames == m_frameCount) return;
+
+    setFrames(frames);
+    m_onFrameCountChanged(frames);
+}
+
 void FrameGraph::setFrames(size_t frames) {
+    std::vector<uint64_t> values;
+
+    for (auto& timeline : m_timelines) {
+        values.push_back(timeline.value);
+    }
+
+    wait(values);
+
     m_frameCount = frames;
+    m_frameValues.assign(frames, values);
 
-    for (auto& v : m_fences) {
-        if (v.size() > 0) {
-            vk::Fence::wait(m_engine->renderer().device(), v, true);
-        }
+    for (auto node : m_plan.nodes) {
+        node->createCommandBuffers(m_frameCount);
     }
 
-    m_fences.clear();
+    for (auto& edge : m_edges) {
+        edge->createEvents(m_frameCount);
+    }
 
-    for (size_t i = 0; i < frames; i++) {
-        m_fences.emplace_back();
-        auto& fences = m_fences.back();
+    if (m_profiler != nullptr) {
+        m_profiler->resize(m_frameCount);
+    }
+}
 
-        for (auto node : m_nodes) {
-            vk::FenceCreateInfo info = {};
-            info.flags = vk::FenceCreateFlags::Signaled;
+void FrameGraph::createFrameResources() {
+    //resources of nodes and edges that are already baked may be in use by frames in flight, so they are kept
+    for (auto node : m_plan.nodes) {
+        if (node->m_commandBuffers.size() != m_frameCount) {
+            node->createCommandBuffers(m_frameCount);
+        }
+    }
 
-            fences.emplace_back(m_engine->renderer().device(), info);
+    for (auto& edge : m_edges) {
+        if (edge->signaled.size() != m_frameCount) {
+            edge->createEvents(m_frameCount);
         }
     }
+}
 
-    for (auto& node : m_nodeList) {
-        node->createCommandBuffers(m_frameCount);
+size_t FrameGraph::timeline(const vk::Queue& queue) {
+    for (size_t i = 0; i < m_timelines.size(); i++) {
+        if (m_timelines[i].queue == &queue) return i;
+    }
+
+    //submit infos track the waited timelines in a 64 bit mask
+    if (m_timelines.size() == 64) throw std::runtime_error("Too many FrameGraph queues");
+
+    VkSemaphoreTypeCreateInfoKHR typeInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR };
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeInfo.initialValue = 0;
+
+    vk::SemaphoreCreateInfo info = {};
+    info.next = &typeInfo;
+
+    m_timelines.emplace_back();
+    Timeline& timeline = m_timelines.back();
+    timeline.queue = &queue;
+    timeline.semaphore = std::make_unique<vk::Semaphore>(m_engine->renderer().device(), info);
+
+    return m_timelines.size() - 1;
+}
+
+void FrameGraph::wait(const std::vector<uint64_t>& values) {
+    NOVA_TRACE_ZONE("FrameGraph::wait");
+    std::vector<VkSemaphore> semaphores;
+    std::vector<uint64_t> waitValues;
+
+    for (size_t i = 0; i < values.size(); i++) {
+        if (values[i] == 0) continue;
+        semaphores.push_back(m_timelines[i].semaphore->handle());
+        waitValues.push_back(values[i]);
     }
+
+    if (semaphores.size() == 0) return;
+
+    VkSemaphoreWaitInfoKHR info = { VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR };
+    info.semaphoreCount = static_cast<uint32_t>(semaphores.size());
+    info.pSemaphores = semaphores.data();
+    info.pValues = waitValues.data();
+
+    VkResult result = m_engine->renderer().waitSemaphores()(m_engine->renderer().device().handle(), &info, UINT64_MAX);
+    if (result != VK_SUCCESS) throw std::runtime_error("Could not wait on FrameGraph timelines");
 }
 
-void FrameGraph::bake() {
+void FrameGraph::bake(BakeMode mode) {
+    if (mode == BakeMode::InferEdges) {
+        inferEdges();
+    }
+
     std::unordered_set<FrameNode*> nodes;
     
     for (auto& node : m_nodes) {
         nodes.insert(node);
     }
     
-    m_nodeList = topologicalSort<FrameNode>(nodes, [](const FrameNode* node) {
+    std::vector<FrameNode*> order = topologicalSort<FrameNode>(nodes, [](const FrameNode* node) {
         std::vector<FrameNode*> results;
         for (auto event : node->m_outEvents) {
             results.push_back(event->dest);
@@ -308,48 +764,437 @@ void FrameGraph::bake() {
         return results;
     });
     
-    setFrames(m_frameCount);
-    preSignal();
+    for (auto node : m_nodes) {
+        node->m_timeline = timeline(*node->m_queue);
+    }
+
+    compile(std::move(order));
+    createFrameResources();
 }
 
-void FrameGraph::preSignal() {
-    vk::SubmitInfo info = {};
+void FrameGraph::compile(std::vector<FrameNode*> order) {
+    ExecutionPlan& plan = m_plan;
+    size_t count = order.size();
+    std::unordered_map<FrameNode*, size_t> positions;
+
+    plan.nodes = std::move(order);
+    plan.timelines.clear();
+    plan.serial.clear();
+    plan.parallel.clear();
+    plan.sourceOffsets.clear();
+    plan.sources.clear();
+    plan.destOffsets.clear();
+    plan.dests.clear();
+    plan.frontiers.assign(count * m_timelines.size(), 0);
+    plan.releaseEdges.clear();
+    plan.eventEdges.clear();
+
+    for (size_t i = 0; i < count; i++) {
+        FrameNode* node = plan.nodes[i];
+        positions[node] = i;
+        plan.timelines.push_back(node->m_timeline);
+
+        if (node->recordsInParallel()) {
+            plan.parallel.push_back(i);
+        } else {
+            plan.serial.push_back(i);
+        }
+    }
+
+    plan.sourceOffsets.push_back(0);
 
-    for (auto& node : m_nodes) {
-        info.signalSemaphores.push_back(*node->m_selfSync);
+    for (size_t i = 0; i < count; i++) {
+        FrameNode* node = plan.nodes[i];
+        size_t first = plan.sources.size();
+
+        for (auto event : node->m_inEvents) {
+            size_t source = positions.at(event->source);
+
+            if (std::find(plan.sources.begin() + first, plan.sources.end(), source) == plan.sources.end()) {
+                plan.sources.push_back(source);
+            }
+        }
+
+        plan.sourceOffsets.push_back(plan.sources.size());
+        node->m_submitDirty = true;
     }
 
-    m_engine->renderer().graphicsQueue().submit({ info }, nullptr);
+    plan.destOffsets.push_back(0);
+
+    for (size_t i = 0; i < count; i++) {
+        FrameNode* node = plan.nodes[i];
+        size_t first = plan.dests.size();
+
+        for (auto event : node->m_outEvents) {
+            size_t dest = positions.at(event->dest);
+
+            if (std::find(plan.dests.begin() + first, plan.dests.end(), dest) == plan.dests.end()) {
+                plan.dests.push_back(dest);
+            }
+        }
+
+        plan.destOffsets.push_back(plan.dests.size());
+    }
+
+    for (auto& edge : m_edges) {
+        if (edge->source->m_family != edge->dest->m_family) {
+            plan.releaseEdges.push_back(edge.get());
+        }
+
+        if (edge->source->m_queue == edge->dest->m_queue) {
+            plan.eventEdges.push_back(edge.get());
+        }
+    }
+
+    m_waits.resize(m_timelines.size());
+}
+
+void FrameGraph::inferEdges() {
+    size_t count = m_nodes.size();
+    std::unordered_map<FrameNode*, size_t> indices;
+
+    for (size_t i = 0; i < count; i++) {
+        indices[m_nodes[i]] = i;
+    }
+
+    //existing edges are kept, so baking again only adds what is missing
+    std::unordered_set<uint64_t> existing;
+    std::vector<std::vector<size_t>> successors(count);
+    std::vector<std::vector<bool>> inferred(count);
+
+    for (auto& edge : m_edges) {
+        size_t source = indices.at(edge->source);
+        size_t dest = indices.at(edge->dest);
+
+        if (existing.insert(source * count + dest).second) {
+            successors[source].push_back(dest);
+            inferred[source].push_back(false);
+        }
+    }
+
+    struct Access {
+        bool hasWriter = false;
+        size_t writer;
+        std::vector<size_t> readers;
+        vk::ImageLayout layout = vk::ImageLayout::Undefined;
+    };
+
+    struct NodeAccess {
+        bool write = false;
+        bool image = false;
+        vk::ImageLayout layout;
+    };
+
+    std::unordered_map<const void*, Access> accesses;
+
+    auto infer = [&](size_t source, size_t dest) {
+        if (source == dest || !existing.insert(source * count + dest).second) return;
+        successors[source].push_back(dest);
+        inferred[source].push_back(true);
+    };
+
+    for (size_t i = 0; i < count; i++) {
+        FrameNode* node = m_nodes[i];
+
+        //a resource in several usages of one node counts as written if any of them writes it
+        std::unordered_map<const void*, NodeAccess> resources;
+
+        for (auto& instance : node->m_declaredBuffers) {
+            resources[instance.buffer].write |= ResourceStateTracker::isWrite(instance.usage->m_accessMask);
+        }
+
+        for (auto& instance : node->m_declaredImages) {
+            NodeAccess& nodeAccess = resources[instance.image];
+            nodeAccess.write |= ResourceStateTracker::isWrite(instance.usage->m_accessMask);
+            nodeAccess.image = true;
+            nodeAccess.layout = instance.usage->m_layout;
+        }
+
+        for (auto& pair : resources) {
+            Access& access = accesses[pair.first];
+            const NodeAccess& nodeAccess = pair.second;
+
+            //a layout transition writes the image, even for a read
+            bool write = nodeAccess.write || (nodeAccess.image && nodeAccess.layout != access.layout);
+            if (nodeAccess.image) access.layout = nodeAccess.layout;
+
+            if (write) {
+                //readers since the last write already depend on it, so the write after write edge is implied
+                if (access.readers.size() > 0) {
+                    for (auto reader : access.readers) {
+                        infer(reader, i);
+                    }
+                } else if (access.hasWriter) {
+                    infer(access.writer, i);
+                }
+
+                access.hasWriter = true;
+                access.writer = i;
+                access.readers.clear();
+            } else {
+                if (access.hasWriter) {
+                    infer(access.writer, i);
+                }
+
+                access.readers.push_back(i);
+            }
+        }
+    }
+
+    //manual edges may point against registration order, so sort the combined graph before reducing it
+    std::vector<size_t> inDegree(count);
+    for (auto& list : successors) {
+        for (auto dest : list) {
+            inDegree[dest]++;
+        }
+    }
+
+    std::vector<size_t> order;
+    for (size_t i = 0; i < count; i++) {
+        if (inDegree[i] == 0) order.push_back(i);
+    }
+
+    for (size_t i = 0; i < order.size(); i++) {
+        for (auto dest : successors[order[i]]) {
+            if (--inDegree[dest] == 0) order.push_back(dest);
+        }
+    }
+
+    if (order.size() != count) throw std::runtime_error("Not a Directed Acyclic Graph");
+
+    std::vector<size_t> position(count);
+    for (size_t i = 0; i < count; i++) {
+        position[order[i]] = i;
+    }
+
+    //reach[v] is every node reachable from v, built in reverse topological order
+    //an inferred edge u -> v is dropped if v is reachable through a successor of u that comes earlier in the order
+    size_t words = (count + 63) / 64;
+    std::vector<uint64_t> reach(count * words);
+
+    for (size_t i = count; i-- > 0;) {
+        size_t node = order[i];
+        uint64_t* reachable = &reach[node * words];
+
+        std::vector<size_t> edges(successors[node].size());
+        for (size_t j = 0; j < edges.size(); j++) {
+            edges[j] = j;
+        }
+
+        std::sort(edges.begin(), edges.end(), [&](size_t a, size_t b) {
+            return position[successors[node][a]] < position[successors[node][b]];
+        });
+
+        for (auto j : edges) {
+            size_t dest = successors[node][j];
+            bool implied = (reachable[dest / 64] & (uint64_t(1) << (dest % 64))) != 0;
+
+            if (inferred[node][j]) {
+                if (implied) continue;
+                addEdge(*m_nodes[node], *m_nodes[dest]);
+            }
+
+            const uint64_t* destReachable = &reach[dest * words];
+            for (size_t w = 0; w < words; w++) {
+                reachable[w] |= destReachable[w];
+            }
+
+            reachable[dest / 64] |= uint64_t(1) << (dest % 64);
+        }
+    }
 }
 
 size_t FrameGraph::completedFrames() const {
-    if (m_frame < m_frameCount) return 0;
-    return m_frame - m_frameCount;
+    //frames older than the frame count were waited on before their index was reused
+    size_t frame = m_frame < m_frameCount ? 0 : m_frame - m_frameCount;
+    if (m_timelines.size() == 0) return frame;
+
+    std::vector<uint64_t> counters;
+
+    for (auto& timeline : m_timelines) {
+        uint64_t value = 0;
+        m_engine->renderer().getSemaphoreCounterValue()(m_engine->renderer().device().handle(), timeline.semaphore->handle(), &value);
+        counters.push_back(value);
+    }
+
+    for (; frame < m_frame; frame++) {
+        auto& values = m_frameValues[frame % m_frameCount];
+
+        for (size_t i = 0; i < values.size(); i++) {
+            if (counters[i] < values[i]) return frame;
+        }
+    }
+
+    return frame;
 }
 
 void FrameGraph::submit() {
-    size_t index = m_frame % m_fences.size();
-
-    for (auto node : m_nodeList) {
+    FlightRecorder* recorder = m_engine->flightRecorder();
+    NOVA_FLIGHT_ZONE(recorder, "FrameGraph::submit");
+    ExecutionPlan& plan = m_plan;
+    size_t count = plan.nodes.size();
+    size_t timelineCount = m_timelines.size();
+    size_t index = m_frame % m_frameCount;
+
+    //disabled nodes with external semaphores are still submitted, so they prepare whatever their waits depend on
+    for (auto node : plan.nodes) {
+        if (!node->m_enabled && !node->hasExternalSemaphores()) continue;
         node->preSubmit(m_frame);
     }
 
-    for (auto& event : m_edges) {
-        event->buildBarriers();
+    //decided in reverse submission order, so the consumers of a cullable node are known before it
+    m_submitStats.skippedNodes = 0;
+
+    for (size_t i = count; i-- > 0;) {
+        FrameNode* node = plan.nodes[i];
+        bool active = node->m_enabled && node->hasWork();
+
+        if (active && node->m_cullable) {
+            active = false;
+
+            for (size_t j = plan.destOffsets[i]; j < plan.destOffsets[i + 1]; j++) {
+                if (plan.nodes[plan.dests[j]]->m_active) {
+                    active = true;
+                    break;
+                }
+            }
+        }
+
+        node->m_active = active;
+        node->m_submitted = active || node->hasExternalSemaphores();
+
+        if (!active) {
+            m_submitStats.skippedNodes++;
+        }
     }
 
-    for (size_t i = 0; i < m_nodeList.size(); i++) {
-        auto node = m_nodeList[i];
+    for (auto node : plan.nodes) {
+        if (!node->m_active) continue;
+        node->compileInstances();
+    }
 
-        m_fences[index][i].wait();
-        m_fences[index][i].reset();
+    for (auto edge : plan.releaseEdges) {
+        if (!edge->source->m_active || !edge->dest->m_active) continue;
+        edge->buildReleases();
+    }
+
+    //a single wait for every queue replaces a fence per node
+    {
+        FlightZone zone(recorder, "FrameGraph::wait");
+        wait(m_frameValues[index]);
+    }
 
-        node->submit(m_frame, index, m_fences[index][i]);
+    //the events of this frame index were last waited on by a completed frame
+    for (auto edge : plan.eventEdges) {
+        edge->resetEvent(m_engine->renderer().device(), index);
+        edge->event = nullptr;
     }
 
-    for (auto node : m_nodeList) {
-        node->postSubmit(m_frame);
-        node->clearInstances();
+    //results of the frame that last used this index are complete, so reading them doesn't stall
+    if (m_profiler != nullptr) {
+        m_profiler->beginFrame(m_frame, index);
+    }
+
+    for (auto node : plan.nodes) {
+        node->m_query = m_profiler != nullptr && node->m_active ? m_profiler->addNode(*node, node->m_family) : GpuProfiler::NoQuery;
+    }
+
+    //nodes are batched into one submit per queue, timeline waits may be submitted before their signal
+    for (auto& timeline : m_timelines) {
+        timeline.batch.clear();
+    }
+
+    //the ResourceStateTracker follows submission order, so barriers are planned before recording starts
+    m_lastAccess.clear();
+
+    {
+        NOVA_FLIGHT_ZONE(recorder, "FrameGraph::planBarriers");
+
+        for (auto node : plan.nodes) {
+            if (!node->m_active) continue;
+            node->planBarriers();
+        }
+    }
+
+    //each node records into its own command pool, so nodes can record on separate threads
+    {
+        NOVA_FLIGHT_ZONE(recorder, "FrameGraph::record");
+
+        for (auto i : plan.serial) {
+            NOVA_TRACE_ZONE("FrameNode::submit");
+            FrameNode* node = plan.nodes[i];
+            node->m_recorded = node->m_active ? &node->submit(m_frame, index) : &m_noCommandBuffers;
+        }
+
+        m_engine->threadPool().parallelFor(plan.parallel.size(), [this, &plan, index](size_t i) {
+            NOVA_TRACE_ZONE("FrameNode::submit");
+            FrameNode* node = plan.nodes[plan.parallel[i]];
+            node->m_recorded = node->m_active ? &node->submit(m_frame, index) : &m_noCommandBuffers;
+        });
+    }
+
+    m_submitStats.queueSubmits = 0;
+    m_submitStats.submitInfos = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        FrameNode* node = plan.nodes[i];
+        uint64_t* frontier = &plan.frontiers[i * timelineCount];
+        std::fill(m_waits.begin(), m_waits.end(), 0);
+
+        for (size_t j = plan.sourceOffsets[i]; j < plan.sourceOffsets[i + 1]; j++) {
+            const uint64_t* source = &plan.frontiers[plan.sources[j] * timelineCount];
+
+            for (size_t t = 0; t < timelineCount; t++) {
+                m_waits[t] = std::max(m_waits[t], source[t]);
+            }
+        }
+
+        if (!node->m_submitted) {
+            std::copy(m_waits.begin(), m_waits.end(), frontier);
+            continue;
+        }
+
+        //nodes on the same queue are ordered by submission
+        Timeline& timeline = m_timelines[plan.timelines[i]];
+        m_waits[plan.timelines[i]] = 0;
+        node->m_timelineValue = ++timeline.value;
+
+        std::fill(frontier, frontier + timelineCount, 0);
+        frontier[plan.timelines[i]] = node->m_timelineValue;
+
+        timeline.batch.push_back(node->buildSubmit(m_waits));
+        m_submitStats.submitInfos++;
+    }
+
+    if (m_profiler != nullptr) {
+        m_profiler->endFrame(index);
+    }
+
+    for (auto& timeline : m_timelines) {
+        if (timeline.batch.size() == 0) continue;
+
+        NOVA_FLIGHT_ZONE(recorder, "vk::Queue::submit");
+        timeline.queue->submit(timeline.batch, nullptr);
+        m_submitStats.queueSubmits++;
+    }
+
+    m_submitStats.totalQueueSubmits += m_submitStats.queueSubmits;
+
+    auto& values = m_frameValues[index];
+    values.resize(timelineCount);
+
+    for (size_t i = 0; i < timelineCount; i++) {
+        values[i] = m_timelines[i].value;
+    }
+
+    //skipped nodes keep their instances for the work they still have queued
+    for (auto node : plan.nodes) {
+        if (node->m_active) {
+            node->postSubmit(m_frame);
+            node->clearInstances();
+        } else {
+            node->skip(m_frame);
+        }
     }
 
     m_frame++;
@@ -0,0 +1,194 @@
+#include "NovaEngine/GpuProfiler.h"
+#include "NovaEngine/Renderer.h"
+#include "NovaEngine/FrameGraph.h"
+#include "NovaEngine/Trace.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace Nova;
+
+void NodeTiming::add(double duration, size_t window) {
+    if (m_samples.size() > window) {
+        m_samples.clear();
+        m_sum = 0;
+        m_next = 0;
+    }
+
+    if (m_samples.size() < window) {
+        m_samples.push_back(duration);
+    } else {
+        m_sum -= m_samples[m_next];
+        m_samples[m_next] = duration;
+        m_next = (m_next + 1) % window;
+    }
+
+    m_sum += duration;
+    m_last = duration;
+    m_average = m_sum / m_samples.size();
+}
+
+double NodeTiming::percentile(double p) const {
+    if (m_samples.size() == 0) return 0;
+
+    std::vector<double> samples = m_samples;
+    size_t n = static_cast<size_t>(std::min(std::max(p, 0.0), 1.0) * (samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+    return samples[n];
+}
+
+GpuProfiler::GpuProfiler(Renderer& renderer, size_t frameCount) {
+    if (!renderer.hostQueryReset()) throw std::runtime_error("GPU profiling requires VK_EXT_host_query_reset");
+
+    m_renderer = &renderer;
+    resize(frameCount);
+}
+
+uint64_t GpuProfiler::cpuTime() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+
+const NodeTiming* GpuProfiler::timing(const FrameNode& node) const {
+    auto it = m_timings.find(&node);
+    if (it == m_timings.end()) return nullptr;
+    return &it->second;
+}
+
+void GpuProfiler::beginFrame(size_t frame, size_t index) {
+    Frame& slot = m_frames[index];
+
+    if (slot.pending) {
+        resolve(slot);
+    }
+
+    slot.frame = frame;
+    slot.nodes.clear();
+    slot.families.clear();
+    m_current = index;
+}
+
+uint32_t GpuProfiler::addNode(const FrameNode& node, uint32_t family) {
+    if (m_renderer->timestampValidBits(family) == 0) return NoQuery;
+
+    Frame& slot = m_frames[m_current];
+    uint32_t query = static_cast<uint32_t>(slot.nodes.size() * 2);
+
+    //the frame using this pool has completed, so it can be replaced before recording starts
+    if (query + 2 > slot.capacity) {
+        vk::QueryPoolCreateInfo info = {};
+        info.queryType = vk::QueryType::Timestamp;
+        info.queryCount = std::max<uint32_t>(64, slot.capacity * 2);
+
+        slot.pool = std::make_unique<vk::QueryPool>(m_renderer->device(), info);
+        slot.capacity = info.queryCount;
+        reset(slot);
+    }
+
+    slot.nodes.push_back(&node);
+    slot.families.push_back(family);
+    return query;
+}
+
+void GpuProfiler::endFrame(size_t index) {
+    Frame& slot = m_frames[index];
+    slot.submitTime = cpuTime();
+    slot.pending = slot.nodes.size() > 0;
+}
+
+void GpuProfiler::writeTimestamp(vk::CommandBuffer& commandBuffer, VkPipelineStageFlagBits stage, uint32_t query) const {
+    vkCmdWriteTimestamp(commandBuffer.handle(), stage, m_frames[m_current].pool->handle(), query);
+}
+
+void GpuProfiler::resolve(Frame& slot) {
+    uint32_t queries = static_cast<uint32_t>(slot.nodes.size() * 2);
+
+    //each query is followed by its availability, nodes skipped this frame never wrote theirs
+    m_results.assign(queries * 2, 0);
+    VkResult result = vkGetQueryPoolResults(m_renderer->device().handle(), slot.pool->handle(), 0, queries, m_results.size() * sizeof(uint64_t), m_results.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    if (result == VK_SUCCESS || result == VK_NOT_READY) {
+        double period = m_renderer->timestampPeriod();
+        int64_t frameOffset = INT64_MAX;
+
+        for (size_t i = 0; i < slot.nodes.size(); i++) {
+            const uint64_t* values = &m_results[i * 4];
+            if (slot.nodes[i] == nullptr || values[1] == 0 || values[3] == 0) continue;
+
+            uint32_t bits = m_renderer->timestampValidBits(slot.families[i]);
+            uint64_t mask = bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+            uint64_t ticks = (values[2] - values[0]) & mask;
+            double duration = ticks * period / 1000000.0;
+
+            NodeTiming& timing = m_timings[slot.nodes[i]];
+            timing.add(duration, m_window);
+            timing.m_frame = slot.frame;
+
+            int64_t start = static_cast<int64_t>(values[0] * period);
+            frameOffset = std::min(frameOffset, start - static_cast<int64_t>(slot.submitTime * 1000));
+
+            if (m_capturing) {
+                m_events.push_back({ slot.nodes[i], slot.families[i], static_cast<uint64_t>(start), static_cast<uint64_t>(ticks * period) });
+            }
+        }
+
+        //later frames can lower the offset, so events keep GPU time and are moved to the CPU clock when written
+        m_clockOffset = std::min(m_clockOffset, frameOffset);
+    }
+
+    reset(slot);
+}
+
+void GpuProfiler::reset(Frame& slot) {
+    m_renderer->resetQueryPool()(m_renderer->device().handle(), slot.pool->handle(), 0, slot.capacity);
+    slot.pending = false;
+}
+
+void GpuProfiler::resize(size_t frames) {
+    //called after the FrameGraph waited on every frame in flight
+    for (auto& slot : m_frames) {
+        if (slot.pending) {
+            resolve(slot);
+        }
+    }
+
+    m_frames.resize(frames);
+    m_current = 0;
+}
+
+void GpuProfiler::forget(const FrameNode& node) {
+    m_timings.erase(&node);
+
+    for (auto& slot : m_frames) {
+        std::replace(slot.nodes.begin(), slot.nodes.end(), &node, static_cast<const FrameNode*>(nullptr));
+    }
+
+    m_events.erase(std::remove_if(m_events.begin(), m_events.end(), [&node](const TraceEvent& event) { return event.node == &node; }), m_events.end());
+}
+
+void GpuProfiler::writeTrace(std::ostream& stream) const {
+    stream << "{\"traceEvents\":[";
+    writeEvents(stream);
+    stream << "]}";
+}
+
+void GpuProfiler::writeEvents(std::ostream& stream) const {
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+    std::vector<uint32_t> families;
+
+    for (auto& event : m_events) {
+        if (std::find(families.begin(), families.end(), event.family) != families.end()) continue;
+        families.push_back(event.family);
+
+        stream << ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << event.family;
+        stream << ",\"args\":{\"name\":\"Queue family " << event.family << "\"}}";
+    }
+
+    for (auto& event : m_events) {
+        stream << ",{\"name\":";
+        Trace::writeString(stream, event.node->name().size() > 0 ? event.node->name() : "FrameNode");
+        stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.family;
+        stream << ",\"ts\":" << static_cast<uint64_t>(static_cast<int64_t>(event.start) - m_clockOffset) / 1000;
+        stream << ",\"dur\":" << event.duration / 1000 << "}";
+    }
+}
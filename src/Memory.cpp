@@ -2,6 +2,7 @@
 #include "NovaEngine/Engine.h"
 #include "NovaEngine/IResourceAllocator.h"
 #include "NovaEngine/FreeListAllocator.h"
+#include "NovaEngine/Trace.h"
 
 #define PAGE_SIZE (256 * 1024 * 1024)
 
@@ -47,8 +48,12 @@ Memory::Memory(Engine& engine) {
 }
 
 MemoryAllocation Memory::allocate(uint32_t type, size_t size) {
+    NOVA_TRACE_ZONE("Memory::allocate");
     if (size > PAGE_SIZE) throw std::runtime_error("Allocation too large");
 
+    m_stats.allocations++;
+    m_stats.allocatedBytes += size;
+
     for (auto& page : m_pages[type]) {
         MemoryAllocation result = page->tryAllocate(size);
         if (result.memory != nullptr) {
@@ -57,12 +62,14 @@ MemoryAllocation Memory::allocate(uint32_t type, size_t size) {
     }
 
     m_pages[type].emplace_back(std::make_unique<Page>(m_engine->renderer().device(), type, PAGE_SIZE));
+    m_stats.pages++;
 
     return m_pages[type].back()->tryAllocate(size);
 }
 
 void Memory::free(MemoryAllocation allocation) {
     if (allocation.memory == nullptr) return;
+    m_stats.frees++;
 
     uint32_t type = allocation.memory->memory().typeIndex();
     for (auto& page : m_pages[type]) {
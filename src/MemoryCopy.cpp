@@ -0,0 +1,191 @@
+#include "NovaEngine/MemoryCopy.h"
+#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NOVA_COPY_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define NOVA_TARGET_SSE2
+#define NOVA_TARGET_AVX2
+#else
+#define NOVA_TARGET_SSE2 __attribute__((target("sse2")))
+#define NOVA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+//only used for write-combined memory, where memcpy gets nothing from the cache, so just the setup cost of the streaming kernels counts
+//CopyBenchmark copies into cached host memory, its crossover doesn't apply here
+#define STREAM_THRESHOLD 256
+
+using namespace Nova;
+
+namespace {
+#ifdef NOVA_COPY_X86
+    bool detectSSE2() {
+#if defined(_M_X64) || defined(__x86_64__)
+        return true;
+#elif defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[3] & (1 << 26)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+#endif
+    }
+
+    bool detectAVX2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx) return false;
+        if ((_xgetbv(0) & 6) != 6) return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    //copies the unaligned head with memcpy so that every store in the main loop is aligned
+    size_t alignHead(char*& dest, const char*& src, size_t size, size_t alignment) {
+        size_t misalignment = reinterpret_cast<uintptr_t>(dest) & (alignment - 1);
+        size_t head = misalignment == 0 ? 0 : alignment - misalignment;
+        if (head > size) head = size;
+
+        memcpy(dest, src, head);
+        dest += head;
+        src += head;
+        return size - head;
+    }
+
+    NOVA_TARGET_SSE2 void copySSE2Stream(void* dest, const void* src, size_t size) {
+        char* d = static_cast<char*>(dest);
+        const char* s = static_cast<const char*>(src);
+        size = alignHead(d, s, size, 16);
+
+        while (size >= 64) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 32));
+            __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 48));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d), a);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d + 16), b);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d + 32), c);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d + 48), e);
+            d += 64;
+            s += 64;
+            size -= 64;
+        }
+
+        while (size >= 16) {
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d), _mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+            d += 16;
+            s += 16;
+            size -= 16;
+        }
+
+        _mm_sfence();
+        memcpy(d, s, size);
+    }
+
+    NOVA_TARGET_AVX2 void copyAVX2Stream(void* dest, const void* src, size_t size) {
+        char* d = static_cast<char*>(dest);
+        const char* s = static_cast<const char*>(src);
+        size = alignHead(d, s, size, 32);
+
+        while (size >= 128) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 32));
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 64));
+            __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 96));
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(d), a);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(d + 32), b);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(d + 64), c);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(d + 96), e);
+            d += 128;
+            s += 128;
+            size -= 128;
+        }
+
+        while (size >= 32) {
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(d), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s)));
+            d += 32;
+            s += 32;
+            size -= 32;
+        }
+
+        _mm_sfence();
+        _mm256_zeroupper();
+        memcpy(d, s, size);
+    }
+
+    const bool hasSSE2 = detectSSE2();
+    const bool hasAVX2 = detectAVX2();
+#endif
+}
+
+bool Nova::copyKernelSupported(CopyKernel kernel) {
+    switch (kernel) {
+    case CopyKernel::Memcpy:
+        return true;
+#ifdef NOVA_COPY_X86
+    case CopyKernel::SSE2Stream:
+        return hasSSE2;
+    case CopyKernel::AVX2Stream:
+        return hasAVX2;
+#endif
+    default:
+        return false;
+    }
+}
+
+CopyKernel Nova::streamingCopyKernel() {
+    if (copyKernelSupported(CopyKernel::AVX2Stream)) return CopyKernel::AVX2Stream;
+    if (copyKernelSupported(CopyKernel::SSE2Stream)) return CopyKernel::SSE2Stream;
+    return CopyKernel::Memcpy;
+}
+
+const char* Nova::copyKernelName(CopyKernel kernel) {
+    switch (kernel) {
+    case CopyKernel::Memcpy: return "memcpy";
+    case CopyKernel::SSE2Stream: return "sse2-stream";
+    case CopyKernel::AVX2Stream: return "avx2-stream";
+    default: return "unknown";
+    }
+}
+
+void Nova::copyMemory(void* dest, const void* src, size_t size, CopyKernel kernel) {
+    switch (kernel) {
+#ifdef NOVA_COPY_X86
+    case CopyKernel::SSE2Stream:
+        copySSE2Stream(dest, src, size);
+        return;
+    case CopyKernel::AVX2Stream:
+        copyAVX2Stream(dest, src, size);
+        return;
+#endif
+    default:
+        memcpy(dest, src, size);
+        return;
+    }
+}
+
+void Nova::copyToMapped(void* dest, const void* src, size_t size, bool hostCached) {
+    static const CopyKernel kernel = streamingCopyKernel();
+
+    if (hostCached || size < STREAM_THRESHOLD) {
+        memcpy(dest, src, size);
+    } else {
+        copyMemory(dest, src, size, kernel);
+    }
+}
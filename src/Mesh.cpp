@@ -18,6 +18,17 @@ void VertexData::fill(TransferNode& transferNode, const void* data, size_t verte
     transferNode.transfer(data, *m_buffer, copy);
 }
 
+void VertexData::update(TransferNode& transferNode, const void* data, size_t firstVertex, size_t vertexCount) {
+    if (firstVertex + vertexCount > m_vertexCount) throw std::runtime_error("Update outside of VertexData");
+
+    size_t stride = vk::getFormatSize(m_format);
+
+    vk::BufferCopy copy = {};
+    copy.dstOffset = firstVertex * stride;
+    copy.size = vertexCount * stride;
+    transferNode.transfer(data, *m_buffer, copy);
+}
+
 void VertexData::createBuffer() {
     m_size = m_vertexCount * vk::getFormatSize(m_format);
 
@@ -0,0 +1,74 @@
+#include "NovaEngine/MirroredBuffer.h"
+#include "NovaEngine/TransferNode.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace Nova;
+
+MirroredBuffer::MirroredBuffer(BufferAllocator& allocator, const vk::BufferCreateInfo& info) {
+    vk::BufferCreateInfo createInfo = info;
+    createInfo.usage |= vk::BufferUsageFlags::TransferDst;
+
+    m_buffer = std::make_unique<Buffer>(allocator.allocate(createInfo, vk::MemoryPropertyFlags::DeviceLocal, {}));
+    m_data.resize(info.size);
+}
+
+MirroredBuffer::~MirroredBuffer() {
+    if (m_transferNode != nullptr) {
+        m_transferNode->removeMirror(*this);
+    }
+}
+
+void MirroredBuffer::write(TransferNode& transferNode, size_t offset, const void* data, size_t size) {
+    memcpy(map(transferNode, offset, size), data, size);
+}
+
+void* MirroredBuffer::map(TransferNode& transferNode, size_t offset, size_t size) {
+    if (offset + size > m_data.size()) throw std::runtime_error("Write outside of MirroredBuffer");
+
+    markDirty(transferNode, offset, size);
+    return m_data.data() + offset;
+}
+
+void MirroredBuffer::markDirty(TransferNode& transferNode, size_t offset, size_t size) {
+    if (size == 0) return;
+
+    if (m_transferNode == nullptr) {
+        m_transferNode = &transferNode;
+        m_transferNode->addMirror(*this);
+    } else if (m_transferNode != &transferNode) {
+        throw std::runtime_error("MirroredBuffer written through multiple TransferNodes in one frame");
+    }
+
+    //keep ranges sorted and merge any that overlap or touch
+    //the CPU copy always holds the latest bytes, so later writes win
+    size_t start = offset;
+    size_t end = offset + size;
+
+    auto first = std::lower_bound(m_dirty.begin(), m_dirty.end(), start, [](const Range& range, size_t value) {
+        return range.offset + range.size < value;
+    });
+
+    auto last = first;
+    while (last != m_dirty.end() && last->offset <= end) {
+        start = std::min(start, last->offset);
+        end = std::max(end, last->offset + last->size);
+        last++;
+    }
+
+    first = m_dirty.erase(first, last);
+    m_dirty.insert(first, { start, end - start });
+}
+
+void MirroredBuffer::flush(TransferNode& transferNode) {
+    for (auto& range : m_dirty) {
+        vk::BufferCopy copy = {};
+        copy.dstOffset = range.offset;
+        copy.size = range.size;
+
+        transferNode.transfer(m_data.data() + range.offset, *m_buffer, copy);
+    }
+
+    m_dirty.clear();
+    m_transferNode = nullptr;
+}
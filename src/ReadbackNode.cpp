@@ -0,0 +1,206 @@
+#include "NovaEngine/ReadbackNode.h"
+#include "NovaEngine/Engine.h"
+
+using namespace Nova;
+
+ReadbackNode::ReadbackNode(Engine& engine, const vk::Queue& queue, FrameGraph& frameGraph, size_t pageSize) : FrameNode(queue, vk::PipelineStageFlags::Transfer, vk::PipelineStageFlags::Transfer) {
+    m_engine = &engine;
+    m_frameGraph = &frameGraph;
+    m_pageSize = pageSize;
+
+    m_bufferUsage = &FrameNode::addBufferUsage(vk::PipelineStageFlags::Transfer, vk::AccessFlags::TransferRead);
+    m_imageUsage = &FrameNode::addImageUsage(vk::PipelineStageFlags::Transfer, vk::AccessFlags::TransferRead, vk::ImageLayout::TransferSrcOptimal);
+
+    findType();
+
+    m_onFrameCountChanged = m_frameGraph->onFrameCountChanged().connect(boost::bind(&ReadbackNode::resize, this, _1));
+    resize(m_frameGraph->frameCount());
+}
+
+void ReadbackNode::findType() {
+    //cached memory is much faster for the CPU to read
+    vk::MemoryPropertyFlags required = vk::MemoryPropertyFlags::HostVisible | vk::MemoryPropertyFlags::HostCoherent;
+
+    if (findType(required | vk::MemoryPropertyFlags::HostCached)) return;
+    if (findType(required)) return;
+
+    throw std::runtime_error("Could not find memory type for readback");
+}
+
+bool ReadbackNode::findType(vk::MemoryPropertyFlags flags) {
+    vk::BufferCreateInfo info = {};
+    info.size = m_pageSize;
+    info.usage = vk::BufferUsageFlags::TransferDst;
+
+    vk::Buffer buffer = vk::Buffer(m_engine->renderer().device(), info);
+    vk::MemoryRequirements requirements = buffer.requirements();
+
+    auto& properties = m_engine->memory().properties();
+
+    for (uint32_t i = 0; i < properties.memoryTypes.size(); i++) {
+        if ((requirements.memoryTypeBits & (1 << i)) != 0) {
+            auto& type = properties.memoryTypes[i];
+            if ((type.propertyFlags & flags) == flags) {
+                m_type = i;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void ReadbackNode::resize(size_t frames) {
+    for (size_t i = frames; i < m_pending.size(); i++) {
+        resolve(i);
+    }
+
+    m_pending.resize(frames);
+
+    if (frames == m_allocators.size()) {
+        return;
+    } else if (frames < m_allocators.size()) {
+        m_allocators.erase(m_allocators.begin() + frames, m_allocators.end());
+    } else {
+        for (size_t i = m_allocators.size(); i < frames; i++) {
+            m_allocators.emplace_back(*m_engine, m_pageSize, m_type, vk::BufferUsageFlags::TransferDst);
+        }
+    }
+}
+
+void ReadbackNode::resolve(size_t index) {
+    //called after the FrameGraph has waited on this index, so the copies are complete
+    for (auto& readback : m_pending[index]) {
+        const char* data = static_cast<const char*>(readback.range.data);
+        readback.result->m_data.assign(data, data + readback.size);
+        readback.result->m_ready = true;
+    }
+
+    m_pending[index].clear();
+    m_allocators[index].reset();
+}
+
+void ReadbackNode::resolveCompleted() {
+    size_t completed = 0;
+    bool queried = false;
+
+    for (size_t i = 0; i < m_pending.size(); i++) {
+        if (m_pending[i].size() == 0) continue;
+
+        //queries the timelines, so only once something is pending
+        if (!queried) {
+            completed = m_frameGraph->completedFrames();
+            queried = true;
+        }
+
+        if (m_pending[i].front().result->m_frame < completed) {
+            resolve(i);
+        }
+    }
+}
+
+void ReadbackNode::preSubmit(size_t frame) {
+    resolveCompleted();
+}
+
+void ReadbackNode::skip(size_t frame) {
+    resolveCompleted();
+}
+
+std::vector<const vk::CommandBuffer*>& ReadbackNode::submit(size_t frame, size_t index) {
+    m_commandBuffers.clear();
+    //the FrameGraph waited on this index, so anything still pending here is complete
+    resolve(index);
+
+    StagingAllocator& allocator = m_allocators[index];
+
+    vk::CommandBuffer& commandBuffer = commandBuffers()[index];
+    commandBuffer.reset({});
+
+    vk::CommandBufferBeginInfo beginInfo = {};
+    beginInfo.flags = vk::CommandBufferUsageFlags::OneTimeSubmit;
+
+    commandBuffer.begin(beginInfo);
+
+    FrameNode::preRecord(commandBuffer);
+
+    for (auto& readback : m_readbacks) {
+        readback.result->m_frame = frame;
+        record(commandBuffer, allocator, readback);
+    }
+
+    if (m_readbacks.size() > 0) {
+        vk::BufferMemoryBarrier barrier = {};
+        barrier.buffer = &allocator.buffer();
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        barrier.srcAccessMask = vk::AccessFlags::TransferWrite;
+        barrier.dstAccessMask = vk::AccessFlags::HostRead;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlags::Transfer, vk::PipelineStageFlags::Host, {}, {}, { barrier }, {});
+    }
+
+    FrameNode::postRecord(commandBuffer);
+
+    commandBuffer.end();
+    m_commandBuffers.push_back(&commandBuffer);
+
+    m_pending[index] = std::move(m_readbacks);
+    m_readbacks.clear();
+    return m_commandBuffers;
+}
+
+void ReadbackNode::record(vk::CommandBuffer& commandBuffer, StagingAllocator& allocator, Readback& readback) {
+    readback.range = allocator.reserve(readback.size);
+
+    if (readback.buffer != nullptr) {
+        vk::BufferCopy copy = readback.bufferCopy;
+        copy.dstOffset = readback.range.offset;
+
+        commandBuffer.copyBuffer(readback.buffer->resource(), allocator.buffer(), copy);
+    } else if (readback.image != nullptr) {
+        vk::BufferImageCopy copy = readback.bufferImageCopy;
+        copy.bufferOffset = readback.range.offset;
+        copy.bufferRowLength = 0;
+        copy.bufferImageHeight = 0;
+
+        commandBuffer.copyImageToBuffer(readback.image->resource(), vk::ImageLayout::TransferSrcOptimal, allocator.buffer(), copy);
+    }
+}
+
+ReadbackHandle ReadbackNode::readback(const Buffer& buffer, vk::BufferCopy copy) {
+    Readback readback = {};
+    readback.buffer = &buffer;
+    readback.bufferCopy = copy;
+    readback.size = copy.size;
+    readback.result = std::make_shared<ReadbackResult>();
+    m_readbacks.push_back(readback);
+
+    m_bufferUsage->add(buffer, copy.srcOffset, copy.size);
+
+    return readback.result;
+}
+
+ReadbackHandle ReadbackNode::readback(const Image& image, vk::BufferImageCopy copy) {
+    size_t texels = copy.imageExtent.width * copy.imageExtent.height * copy.imageExtent.depth;
+
+    Readback readback = {};
+    readback.image = &image;
+    readback.bufferImageCopy = copy;
+    readback.size = texels * vk::getFormatSize(image.resource().format());
+    readback.result = std::make_shared<ReadbackResult>();
+    m_readbacks.push_back(readback);
+
+    vk::ImageSubresourceRange range = {};
+    range.aspectMask = copy.imageSubresource.aspectMask;
+    range.baseArrayLayer = copy.imageSubresource.baseArrayLayer;
+    range.layerCount = copy.imageSubresource.layerCount;
+    range.baseMipLevel = copy.imageSubresource.mipLevel;
+    range.levelCount = 1;
+
+    m_imageUsage->add(image, range);
+
+    return readback.result;
+}
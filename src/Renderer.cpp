@@ -1,13 +1,16 @@
 #include "NovaEngine/Renderer.h"
 #include "NovaEngine/Window.h"
 #include <unordered_set>
+#include <algorithm>
+#include <cstring>
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
 using namespace Nova;
 
 const std::vector<std::string> deviceExtensions = {
-    VK_KHR_SWAPCHAIN_EXTENSION_NAME
+    VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+    VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME
 };
 
 std::vector<std::string> merge(const std::vector<std::string>& a, const std::vector<std::string>& b) {
@@ -30,6 +33,17 @@ std::vector<std::string> merge(const std::vector<std::string>& a, const std::vec
     return result;
 }
 
+//the device extensions the Renderer uses depend on VK_KHR_get_physical_device_properties2, which createInstance enables
+bool getFeatures(const vk::PhysicalDevice& physicalDevice, void* features) {
+    auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(vkGetInstanceProcAddr(physicalDevice.instance().handle(), "vkGetPhysicalDeviceFeatures2KHR"));
+    if (getFeatures2 == nullptr) return false;
+
+    VkPhysicalDeviceFeatures2KHR info = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR };
+    info.pNext = features;
+    getFeatures2(physicalDevice.handle(), &info);
+    return true;
+}
+
 Renderer::Renderer(const std::string& appName, const std::vector<std::string>& extensions, const std::vector<std::string>& layers) {
     createInstance(appName, extensions, layers);
 }
@@ -52,7 +66,26 @@ bool Renderer::isValid(const vk::PhysicalDevice& physicalDevice) {
         }
     }
 
-    return graphicsFound && presentFound;
+    uint32_t count;
+    vkEnumerateDeviceExtensionProperties(physicalDevice.handle(), nullptr, &count, nullptr);
+    std::vector<VkExtensionProperties> properties(count);
+    vkEnumerateDeviceExtensionProperties(physicalDevice.handle(), nullptr, &count, properties.data());
+
+    bool timelineFound = false;
+
+    for (auto& property : properties) {
+        if (strcmp(property.extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0) {
+            timelineFound = true;
+        }
+    }
+
+    if (!timelineFound) return false;
+
+    //the extension alone doesn't mean the feature is supported
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphore = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR };
+    if (!getFeatures(physicalDevice, &timelineSemaphore)) return false;
+
+    return graphicsFound && presentFound && timelineSemaphore.timelineSemaphore == VK_TRUE;
 }
 
 void Renderer::createInstance(const std::string& appName, const std::vector<std::string>& extensions, const std::vector<std::string>& layers) {
@@ -70,6 +103,8 @@ void Renderer::createInstance(const std::string& appName, const std::vector<std:
         requiredExtensionsV.emplace_back(requiredExtensions[i]);
     }
 
+    requiredExtensionsV.emplace_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
     std::vector<std::string> extensionList = merge(requiredExtensionsV, extensions);
 
     vk::InstanceCreateInfo info = {};
@@ -90,9 +125,11 @@ void Renderer::createDevice(const vk::PhysicalDevice& physicalDevice, const std:
     uint32_t graphicsFamily;
     uint32_t presentFamily;
     uint32_t transferFamily;
+    uint32_t computeFamily;
     bool graphicsFound = false;
     bool presentFound = false;
     bool transferFound = false;
+    bool computeFound = false;
 
     for (uint32_t i = 0; i < physicalDevice.queueFamilies().size(); i++) {
         auto& family = physicalDevice.queueFamilies()[i];
@@ -116,14 +153,25 @@ void Renderer::createDevice(const vk::PhysicalDevice& physicalDevice, const std:
             transferFamily = i;
         }
 
-        if (graphicsFound && presentFound && transferFound) break;
+        if (!computeFound && family.queueCount > 0
+            && (family.queueFlags & vk::QueueFlags::Compute) == vk::QueueFlags::Compute
+            && (family.queueFlags & vk::QueueFlags::Graphics) == vk::QueueFlags::None) {
+            computeFound = true;
+            computeFamily = i;
+        }
+
+        if (graphicsFound && presentFound && transferFound && computeFound) break;
     }
 
     if (!transferFound) {
         transferFamily = graphicsFamily;
     }
 
-    std::unordered_set<uint32_t> families = { graphicsFamily, presentFamily, transferFamily };
+    if (!computeFound) {
+        computeFamily = graphicsFamily;
+    }
+
+    std::unordered_set<uint32_t> families = { graphicsFamily, presentFamily, transferFamily, computeFamily };
     std::vector<vk::DeviceQueueCreateInfo> queueInfos;
     float priority = 1;
 
@@ -147,9 +195,63 @@ void Renderer::createDevice(const vk::PhysicalDevice& physicalDevice, const std:
     info.enabledFeatures = &features_;
     info.enabledExtensionNames = std::move(extensionList);
 
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphore = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR };
+    timelineSemaphore.timelineSemaphore = VK_TRUE;
+    info.next = &timelineSemaphore;
+    void** next = &timelineSemaphore.pNext;
+
+#ifdef VK_KHR_synchronization2
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR };
+
+    if (std::find(extensions.begin(), extensions.end(), VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) != extensions.end()
+        && getFeatures(physicalDevice, &synchronization2) && synchronization2.synchronization2 == VK_TRUE) {
+        *next = &synchronization2;
+        next = &synchronization2.pNext;
+        m_synchronization2 = true;
+    }
+#endif
+
+    VkPhysicalDeviceHostQueryResetFeaturesEXT hostQueryReset = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES_EXT };
+
+    if (std::find(extensions.begin(), extensions.end(), VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME) != extensions.end()
+        && getFeatures(physicalDevice, &hostQueryReset) && hostQueryReset.hostQueryReset == VK_TRUE) {
+        *next = &hostQueryReset;
+        next = &hostQueryReset.pNext;
+        m_hostQueryReset = true;
+    }
+
     m_device = std::make_unique<vk::Device>(physicalDevice, info);
 
+    m_waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(m_device->handle(), "vkWaitSemaphoresKHR"));
+    m_getSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(vkGetDeviceProcAddr(m_device->handle(), "vkGetSemaphoreCounterValueKHR"));
+
+    if (m_waitSemaphores == nullptr || m_getSemaphoreCounterValue == nullptr) {
+        throw std::runtime_error("Could not load VK_KHR_timeline_semaphore functions");
+    }
+
+#ifdef VK_KHR_synchronization2
+    if (m_synchronization2) {
+        m_cmdPipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(vkGetDeviceProcAddr(m_device->handle(), "vkCmdPipelineBarrier2KHR"));
+        m_synchronization2 = m_cmdPipelineBarrier2 != nullptr;
+    }
+#endif
+
+    if (m_hostQueryReset) {
+        m_resetQueryPool = reinterpret_cast<PFN_vkResetQueryPoolEXT>(vkGetDeviceProcAddr(m_device->handle(), "vkResetQueryPoolEXT"));
+        m_hostQueryReset = m_resetQueryPool != nullptr;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice.handle(), &properties);
+    m_timestampPeriod = properties.limits.timestampPeriod;
+
+    m_timestampValidBits.clear();
+    for (auto& family : physicalDevice.queueFamilies()) {
+        m_timestampValidBits.push_back(family.timestampValidBits);
+    }
+
     m_graphicsQueue = &m_device->getQueue(graphicsFamily, 0);
     m_presentQueue = &m_device->getQueue(presentFamily, 0);
     m_transferQueue = &m_device->getQueue(transferFamily, 0);
+    m_computeQueue = &m_device->getQueue(computeFamily, 0);
 }
\ No newline at end of file
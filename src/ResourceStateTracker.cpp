@@ -0,0 +1,349 @@
+#include "NovaEngine/ResourceStateTracker.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace Nova;
+
+namespace {
+    const VkFlags WRITE_ACCESS = VK_ACCESS_SHADER_WRITE_BIT
+        | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+        | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+        | VK_ACCESS_TRANSFER_WRITE_BIT
+        | VK_ACCESS_HOST_WRITE_BIT
+        | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    template<typename T>
+    VkFlags bits(T flags) {
+        return static_cast<VkFlags>(flags);
+    }
+
+    //true if every bit of b is in a
+    template<typename T>
+    bool contains(T a, T b) {
+        return (bits(b) & ~bits(a)) == 0;
+    }
+}
+
+bool ResourceStateTracker::Transition::operator == (const Transition& other) const {
+    return needed == other.needed
+        && srcStages == other.srcStages
+        && dstStages == other.dstStages
+        && srcAccess == other.srcAccess
+        && dstAccess == other.dstAccess
+        && oldLayout == other.oldLayout
+        && newLayout == other.newLayout
+        && srcFamily == other.srcFamily
+        && dstFamily == other.dstFamily;
+}
+
+bool ResourceStateTracker::isWrite(vk::AccessFlags access) {
+    return (bits(access) & WRITE_ACCESS) != 0;
+}
+
+ResourceStateTracker::State ResourceStateTracker::initialState() {
+    State state = {};
+    state.layout = vk::ImageLayout::Undefined;
+    state.family = VK_QUEUE_FAMILY_IGNORED;
+    state.releasedTo = VK_QUEUE_FAMILY_IGNORED;
+    return state;
+}
+
+ResourceStateTracker::Transition ResourceStateTracker::apply(State& state, const ResourceAccess& access, bool image) {
+    Transition transition = {};
+    transition.dstStages = access.stages;
+    transition.dstAccess = access.access;
+    transition.oldLayout = image ? state.layout : vk::ImageLayout::Undefined;
+    transition.newLayout = image ? access.layout : vk::ImageLayout::Undefined;
+    transition.srcFamily = VK_QUEUE_FAMILY_IGNORED;
+    transition.dstFamily = VK_QUEUE_FAMILY_IGNORED;
+
+    bool write = isWrite(access.access);
+    vk::AccessFlags writeAccess = static_cast<vk::AccessFlags>(bits(access.access) & WRITE_ACCESS);
+
+    if (state.releasedTo != VK_QUEUE_FAMILY_IGNORED) {
+        if (state.releasedTo == access.family) {
+            //acquire half of the ownership transfer, must match the release exactly
+            transition.needed = true;
+            transition.srcStages = vk::PipelineStageFlags::TopOfPipe;
+            transition.newLayout = image ? state.releasedLayout : vk::ImageLayout::Undefined;
+            transition.srcFamily = state.family;
+            transition.dstFamily = access.family;
+
+            state.layout = state.releasedLayout;
+            state.family = access.family;
+            state.releasedTo = VK_QUEUE_FAMILY_IGNORED;
+            state.writeStages = access.stages;
+            state.writeAccess = writeAccess;
+            state.readStages = write ? vk::PipelineStageFlags::None : access.stages;
+            state.visibleStages = access.stages;
+            state.visibleAccess = access.access;
+            return transition;
+        }
+
+        //released to a different family than the one using it, so there is nothing to acquire
+        state.releasedTo = VK_QUEUE_FAMILY_IGNORED;
+    }
+
+    if (state.family != VK_QUEUE_FAMILY_IGNORED && state.family != access.family) {
+        //without an ownership transfer the contents are undefined on the new family, which only an access that doesn't read can accept
+        if ((bits(access.access) & ~WRITE_ACCESS) != 0) {
+            throw std::runtime_error("Resource read on a queue family that doesn't own it, without an ownership transfer");
+        }
+
+        state = initialState();
+    }
+
+    bool layoutChange = image && state.layout != access.layout;
+
+    if (write || layoutChange) {
+        //a layout transition is a write, so it also has to wait for earlier reads
+        vk::PipelineStageFlags previous = state.writeStages | state.readStages;
+
+        if (layoutChange || previous != vk::PipelineStageFlags::None) {
+            transition.needed = true;
+            transition.srcStages = previous != vk::PipelineStageFlags::None ? previous : vk::PipelineStageFlags::TopOfPipe;
+            transition.srcAccess = state.writeAccess;
+        }
+
+        state.layout = image ? access.layout : vk::ImageLayout::Undefined;
+        state.writeStages = access.stages;
+        state.writeAccess = writeAccess;
+        state.readStages = write ? vk::PipelineStageFlags::None : access.stages;
+        state.visibleStages = access.stages;
+        state.visibleAccess = access.access;
+    } else {
+        //read after read, or a read the last write is already visible to, needs no barrier
+        bool visible = contains(state.visibleStages, access.stages) && contains(state.visibleAccess, access.access);
+
+        if (state.writeStages != vk::PipelineStageFlags::None && !visible) {
+            transition.needed = true;
+            transition.srcStages = state.writeStages;
+            transition.srcAccess = state.writeAccess;
+
+            state.visibleStages |= access.stages;
+            state.visibleAccess |= access.access;
+        }
+
+        state.readStages |= access.stages;
+    }
+
+    state.family = access.family;
+    return transition;
+}
+
+ResourceStateTracker::Transition ResourceStateTracker::applyRelease(State& state, uint32_t family, uint32_t dstFamily, vk::ImageLayout layout) {
+    vk::PipelineStageFlags previous = state.writeStages | state.readStages;
+
+    Transition transition = {};
+    transition.needed = true;
+    transition.srcStages = previous != vk::PipelineStageFlags::None ? previous : vk::PipelineStageFlags::TopOfPipe;
+    transition.srcAccess = state.writeAccess;
+    transition.dstStages = vk::PipelineStageFlags::BottomOfPipe;
+    transition.oldLayout = state.layout;
+    transition.newLayout = layout;
+    transition.srcFamily = family;
+    transition.dstFamily = dstFamily;
+
+    state.family = family;
+    state.releasedTo = dstFamily;
+    state.releasedLayout = layout;
+    return transition;
+}
+
+vk::ImageLayout ResourceStateTracker::layout(const vk::Image& image, uint32_t level, uint32_t layer) const {
+    auto it = m_images.find(&image);
+    if (it == m_images.end()) return vk::ImageLayout::Undefined;
+
+    const ImageState& state = it->second;
+    if (level >= state.levels || layer >= state.layers) return vk::ImageLayout::Undefined;
+
+    return state.states[level * state.layers + layer].layout;
+}
+
+bool ResourceStateTracker::owned(const State& state, uint32_t family) {
+    return state.family == VK_QUEUE_FAMILY_IGNORED || state.family == family || state.releasedTo == family;
+}
+
+bool ResourceStateTracker::owned(const vk::Buffer& buffer, uint32_t family) const {
+    auto it = m_buffers.find(&buffer);
+    return it == m_buffers.end() || owned(it->second, family);
+}
+
+bool ResourceStateTracker::owned(const vk::Image& image, vk::ImageSubresourceRange range, uint32_t family) const {
+    auto it = m_images.find(&image);
+    if (it == m_images.end()) return true;
+
+    const ImageState& state = it->second;
+    uint32_t levelEnd = range.levelCount == VK_REMAINING_MIP_LEVELS ? state.levels : std::min(range.baseMipLevel + range.levelCount, state.levels);
+    uint32_t layerEnd = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? state.layers : std::min(range.baseArrayLayer + range.layerCount, state.layers);
+
+    for (uint32_t level = range.baseMipLevel; level < levelEnd; level++) {
+        for (uint32_t layer = range.baseArrayLayer; layer < layerEnd; layer++) {
+            if (!owned(state.states[level * state.layers + layer], family)) return false;
+        }
+    }
+
+    return true;
+}
+
+void ResourceStateTracker::use(const vk::Buffer& buffer, const ResourceAccess& access, std::vector<BufferBarrierInfo>& barriers) {
+    auto it = m_buffers.find(&buffer);
+    if (it == m_buffers.end()) {
+        it = m_buffers.insert({ &buffer, initialState() }).first;
+    }
+
+    Transition transition = apply(it->second, access, false);
+    if (!transition.needed) return;
+
+    vk::BufferMemoryBarrier barrier = {};
+    barrier.buffer = &buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    barrier.srcAccessMask = transition.srcAccess;
+    barrier.dstAccessMask = transition.dstAccess;
+    barrier.srcQueueFamilyIndex = transition.srcFamily;
+    barrier.dstQueueFamilyIndex = transition.dstFamily;
+
+    barriers.push_back({ barrier, transition.srcStages, transition.dstStages });
+}
+
+void ResourceStateTracker::use(const vk::Image& image, vk::ImageSubresourceRange range, const ResourceAccess& access, std::vector<ImageBarrierInfo>& barriers) {
+    addImageBarriers(image, range, barriers, [&access](State& state) {
+        return apply(state, access, true);
+    });
+}
+
+void ResourceStateTracker::release(const vk::Buffer& buffer, uint32_t family, uint32_t dstFamily, std::vector<BufferBarrierInfo>& barriers) {
+    auto it = m_buffers.find(&buffer);
+    if (it == m_buffers.end()) {
+        it = m_buffers.insert({ &buffer, initialState() }).first;
+    }
+
+    Transition transition = applyRelease(it->second, family, dstFamily, vk::ImageLayout::Undefined);
+
+    vk::BufferMemoryBarrier barrier = {};
+    barrier.buffer = &buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    barrier.srcAccessMask = transition.srcAccess;
+    barrier.srcQueueFamilyIndex = transition.srcFamily;
+    barrier.dstQueueFamilyIndex = transition.dstFamily;
+
+    barriers.push_back({ barrier, transition.srcStages, transition.dstStages });
+}
+
+void ResourceStateTracker::release(const vk::Image& image, vk::ImageSubresourceRange range, uint32_t family, uint32_t dstFamily, vk::ImageLayout layout, std::vector<ImageBarrierInfo>& barriers) {
+    addImageBarriers(image, range, barriers, [family, dstFamily, layout](State& state) {
+        return applyRelease(state, family, dstFamily, layout);
+    });
+}
+
+void ResourceStateTracker::reset(const vk::Buffer& buffer, uint32_t family) {
+    State state = initialState();
+    state.family = family;
+    m_buffers[&buffer] = state;
+}
+
+void ResourceStateTracker::reset(const vk::Image& image, vk::ImageSubresourceRange range, vk::ImageLayout layout, uint32_t family) {
+    State idle = initialState();
+    idle.layout = layout;
+    idle.family = family;
+
+    std::vector<ImageBarrierInfo> unused;
+    addImageBarriers(image, range, unused, [&idle](State& state) {
+        state = idle;
+        return Transition{};
+    });
+}
+
+void ResourceStateTracker::forget(const vk::Buffer& buffer) {
+    m_buffers.erase(&buffer);
+}
+
+void ResourceStateTracker::forget(const vk::Image& image) {
+    m_images.erase(&image);
+}
+
+ResourceStateTracker::ImageState& ResourceStateTracker::imageState(const vk::Image& image) {
+    auto it = m_images.find(&image);
+    if (it != m_images.end()) return it->second;
+
+    ImageState state = {};
+    state.levels = image.mipLevels();
+    state.layers = image.arrayLayers();
+    state.states.resize(static_cast<size_t>(state.levels) * state.layers, initialState());
+
+    return m_images.insert({ &image, std::move(state) }).first->second;
+}
+
+void ResourceStateTracker::addImageBarriers(const vk::Image& image, vk::ImageSubresourceRange range, std::vector<ImageBarrierInfo>& barriers, const std::function<Transition(State&)>& function) {
+    struct Run {
+        uint32_t baseLayer;
+        uint32_t layerCount;
+        Transition transition;
+        size_t barrier;
+    };
+
+    ImageState& state = imageState(image);
+
+    if (range.levelCount == VK_REMAINING_MIP_LEVELS) range.levelCount = state.levels - range.baseMipLevel;
+    if (range.layerCount == VK_REMAINING_ARRAY_LAYERS) range.layerCount = state.layers - range.baseArrayLayer;
+
+    uint32_t levelEnd = std::min(range.baseMipLevel + range.levelCount, state.levels);
+    uint32_t layerEnd = std::min(range.baseArrayLayer + range.layerCount, state.layers);
+
+    //subresources in different states get separate barriers, so partial updates don't touch the rest of the image
+    //runs of layers that match the previous level extend its barriers instead
+    std::vector<Run> previous;
+    std::vector<Run> current;
+
+    for (uint32_t level = range.baseMipLevel; level < levelEnd; level++) {
+        current.clear();
+
+        for (uint32_t layer = range.baseArrayLayer; layer < layerEnd; layer++) {
+            Transition transition = function(state.states[level * state.layers + layer]);
+            if (!transition.needed) continue;
+
+            if (current.size() > 0 && current.back().baseLayer + current.back().layerCount == layer && current.back().transition == transition) {
+                current.back().layerCount++;
+            } else {
+                current.push_back({ layer, 1, transition, 0 });
+            }
+        }
+
+        bool extend = current.size() > 0 && current.size() == previous.size();
+        for (size_t i = 0; extend && i < current.size(); i++) {
+            extend = current[i].baseLayer == previous[i].baseLayer && current[i].layerCount == previous[i].layerCount && current[i].transition == previous[i].transition;
+        }
+
+        if (extend) {
+            for (size_t i = 0; i < current.size(); i++) {
+                current[i].barrier = previous[i].barrier;
+                barriers[current[i].barrier].barrier.subresourceRange.levelCount++;
+            }
+        } else {
+            for (auto& run : current) {
+                const Transition& transition = run.transition;
+
+                vk::ImageMemoryBarrier barrier = {};
+                barrier.image = &image;
+                barrier.oldLayout = transition.oldLayout;
+                barrier.newLayout = transition.newLayout;
+                barrier.srcAccessMask = transition.srcAccess;
+                barrier.dstAccessMask = transition.dstAccess;
+                barrier.srcQueueFamilyIndex = transition.srcFamily;
+                barrier.dstQueueFamilyIndex = transition.dstFamily;
+                barrier.subresourceRange.aspectMask = range.aspectMask;
+                barrier.subresourceRange.baseMipLevel = level;
+                barrier.subresourceRange.levelCount = 1;
+                barrier.subresourceRange.baseArrayLayer = run.baseLayer;
+                barrier.subresourceRange.layerCount = run.layerCount;
+
+                run.barrier = barriers.size();
+                barriers.push_back({ barrier, transition.srcStages, transition.dstStages });
+            }
+        }
+
+        previous.swap(current);
+    }
+}
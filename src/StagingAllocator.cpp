@@ -1,9 +1,10 @@
 #include "NovaEngine/StagingAllocator.h"
 #include "NovaEngine/Engine.h"
+#include "NovaEngine/MemoryCopy.h"
 
 using namespace Nova;
 
-StagingAllocator::StagingAllocator(Engine& engine, size_t pageSize, uint32_t type) {
+StagingAllocator::StagingAllocator(Engine& engine, size_t pageSize, uint32_t type, vk::BufferUsageFlags usage) {
     m_engine = &engine;
     m_memory = &engine.memory();
 
@@ -11,7 +12,7 @@ StagingAllocator::StagingAllocator(Engine& engine, size_t pageSize, uint32_t typ
     m_allocator = std::make_unique<LinearAllocator>(m_page.offset, m_page.size);
 
     vk::BufferCreateInfo info = {};
-    info.usage = vk::BufferUsageFlags::TransferSrc;
+    info.usage = usage;
     info.size = pageSize;
 
     m_buffer = std::make_unique<vk::Buffer>(m_engine->renderer().device(), info);
@@ -41,12 +42,23 @@ StagingAllocator::~StagingAllocator() {
     m_memory->free(m_page);
 }
 
-size_t StagingAllocator::stage(const void* data, size_t size) {
+void* StagingAllocator::mapping() const {
+    return static_cast<void*>(static_cast<char*>(m_page.memory->mapping()) + m_page.offset);
+}
+
+StagingRange StagingAllocator::reserve(size_t size) {
     Allocation allocation = m_allocator->allocate(size, 4);
+    if (allocation.allocator == nullptr) throw std::runtime_error("Staging page full");
+
     void* dest = m_page.memory->mapping();
     dest = static_cast<void*>(static_cast<char*>(dest) + allocation.offset);
-    memcpy(dest, data, size);
-    return allocation.offset - m_page.offset;
+    return { dest, allocation.offset - m_page.offset, size };
+}
+
+size_t StagingAllocator::stage(const void* data, size_t size) {
+    StagingRange range = reserve(size);
+    copyToMapped(range.data, data, size, (flags() & vk::MemoryPropertyFlags::HostCached) == vk::MemoryPropertyFlags::HostCached);
+    return range.offset;
 }
 
 void StagingAllocator::reset() {
@@ -0,0 +1,449 @@
+#include "NovaEngine/StreamingTransfer.h"
+#include "NovaEngine/Engine.h"
+#include "NovaEngine/MemoryCopy.h"
+#include <algorithm>
+
+#define NO_BATCH (~static_cast<size_t>(0))
+
+using namespace Nova;
+
+StreamingTransfer::StreamingTransfer(Engine& engine, size_t pageSize, size_t pageCount) {
+    m_engine = &engine;
+    m_transferQueue = &m_engine->renderer().transferQueue();
+    m_graphicsQueue = &m_engine->renderer().graphicsQueue();
+    m_pageSize = pageSize;
+    m_open = NO_BATCH;
+
+    findType();
+    createCommandBuffers(pageCount);
+
+    //each batch signals its id, on the graphics queue if the acquire half of an ownership transfer has to run there
+    m_timeline = createTimeline();
+
+    if (ownershipTransfer()) {
+        m_copied = createTimeline();
+    }
+
+    for (size_t i = 0; i < pageCount; i++) {
+        Batch batch = {};
+        batch.staging = std::make_unique<StagingAllocator>(*m_engine, m_pageSize, m_type);
+
+        m_batches.emplace_back(std::move(batch));
+        m_free.push_back(pageCount - i - 1);
+    }
+}
+
+StreamingTransfer::~StreamingTransfer() {
+    while (retire(true));
+}
+
+void StreamingTransfer::findType() {
+    vk::BufferCreateInfo info = {};
+    info.size = m_pageSize;
+    info.usage = vk::BufferUsageFlags::TransferSrc;
+
+    vk::Buffer buffer = vk::Buffer(m_engine->renderer().device(), info);
+    vk::MemoryRequirements requirements = buffer.requirements();
+
+    vk::MemoryPropertyFlags flags = vk::MemoryPropertyFlags::HostVisible | vk::MemoryPropertyFlags::HostCoherent;
+    auto& properties = m_engine->memory().properties();
+
+    for (uint32_t i = 0; i < properties.memoryTypes.size(); i++) {
+        if ((requirements.memoryTypeBits & (1 << i)) != 0) {
+            auto& type = properties.memoryTypes[i];
+            if ((type.propertyFlags & flags) == flags) {
+                m_type = i;
+                return;
+            }
+        }
+    }
+}
+
+std::unique_ptr<vk::Semaphore> StreamingTransfer::createTimeline() {
+    VkSemaphoreTypeCreateInfoKHR typeInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR };
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeInfo.initialValue = 0;
+
+    vk::SemaphoreCreateInfo info = {};
+    info.next = &typeInfo;
+
+    return std::make_unique<vk::Semaphore>(m_engine->renderer().device(), info);
+}
+
+void StreamingTransfer::createCommandBuffers(size_t count) {
+    vk::CommandPoolCreateInfo poolInfo = {};
+    poolInfo.queueFamilyIndex = m_transferQueue->familyIndex();
+    poolInfo.flags = vk::CommandPoolCreateFlags::ResetCommandBuffer;
+
+    m_transferPool = std::make_unique<vk::CommandPool>(m_engine->renderer().device(), poolInfo);
+
+    vk::CommandBufferAllocateInfo info = {};
+    info.commandPool = m_transferPool.get();
+    info.commandBufferCount = static_cast<uint32_t>(count);
+
+    m_transferCommands = m_transferPool->allocate(info);
+
+    if (ownershipTransfer()) {
+        //the acquire half of the ownership transfer has to run on the graphics family
+        poolInfo.queueFamilyIndex = m_graphicsQueue->familyIndex();
+        m_graphicsPool = std::make_unique<vk::CommandPool>(m_engine->renderer().device(), poolInfo);
+
+        info.commandPool = m_graphicsPool.get();
+        m_acquireCommands = m_graphicsPool->allocate(info);
+    }
+}
+
+StreamingTransfer::Batch& StreamingTransfer::openBatch(size_t size) {
+    if (size > m_pageSize) throw std::runtime_error("Upload too large for streaming page");
+
+    if (m_open != NO_BATCH) {
+        Batch& batch = m_batches[m_open];
+        size_t used = IGenericAllocator::align(batch.staging->used(), 4);
+        if (used + size <= m_pageSize) {
+            return batch;
+        }
+
+        close();
+    }
+
+    while (m_free.size() == 0) {
+        flush();
+        if (!retire(true)) throw std::runtime_error("Streaming pages exhausted by uncommitted reservations");
+    }
+
+    m_open = m_free.back();
+    m_free.pop_back();
+
+    Batch& batch = m_batches[m_open];
+    batch.id = m_next++;
+    batch.uncommitted = 0;
+    return batch;
+}
+
+bool StreamingTransfer::canReserve(size_t size) {
+    if (size > m_pageSize) return false;
+
+    if (m_open != NO_BATCH) {
+        size_t used = IGenericAllocator::align(m_batches[m_open].staging->used(), 4);
+        if (used + size <= m_pageSize) return true;
+    }
+
+    if (m_free.size() > 0) return true;
+
+    flush();
+    while (retire(false));
+
+    return m_free.size() > 0;
+}
+
+StreamReservation StreamingTransfer::reserve(size_t size, const Buffer& buffer, size_t dstOffset) {
+    Batch& batch = openBatch(size);
+    StagingRange range = batch.staging->reserve(size);
+
+    Copy copy = {};
+    copy.buffer = &buffer;
+    copy.bufferCopy = { range.offset, dstOffset, size };
+    batch.copies.push_back(copy);
+    batch.uncommitted++;
+
+    return { range.data, size, batch.id, batch.copies.size() - 1 };
+}
+
+StreamReservation StreamingTransfer::reserve(const Image& image, vk::ImageLayout finalLayout, vk::BufferImageCopy copy) {
+    size_t texels = copy.imageExtent.width * copy.imageExtent.height * copy.imageExtent.depth;
+    size_t size = texels * vk::getFormatSize(image.resource().format());
+
+    Batch& batch = openBatch(size);
+    StagingRange range = batch.staging->reserve(size);
+
+    Copy imageCopy = {};
+    imageCopy.image = &image;
+    imageCopy.bufferImageCopy = { range.offset, 0, 0, copy.imageSubresource, copy.imageOffset, copy.imageExtent };
+    imageCopy.finalLayout = finalLayout;
+    batch.copies.push_back(imageCopy);
+    batch.uncommitted++;
+
+    return { range.data, size, batch.id, batch.copies.size() - 1 };
+}
+
+void StreamingTransfer::commit(const StreamReservation& reservation) {
+    for (auto& batch : m_batches) {
+        if (batch.id == reservation.id && batch.uncommitted > 0) {
+            batch.uncommitted--;
+            return;
+        }
+    }
+
+    throw std::runtime_error("Reservation is not pending");
+}
+
+void StreamingTransfer::cancel(const StreamReservation& reservation) {
+    for (auto& batch : m_batches) {
+        if (batch.id == reservation.id && batch.uncommitted > 0) {
+            batch.copies[reservation.copy].cancelled = true;
+            batch.uncommitted--;
+            return;
+        }
+    }
+
+    throw std::runtime_error("Reservation is not pending");
+}
+
+StreamID StreamingTransfer::upload(const void* data, size_t size, const Buffer& buffer, size_t dstOffset) {
+    const char* bytes = static_cast<const char*>(data);
+    bool hostCached = (m_engine->memory().properties().memoryTypes[m_type].propertyFlags & vk::MemoryPropertyFlags::HostCached) == vk::MemoryPropertyFlags::HostCached;
+    StreamID id = m_completed;
+
+    //large uploads are split across pages
+    for (size_t offset = 0; offset < size; offset += m_pageSize) {
+        size_t chunk = std::min(size - offset, m_pageSize);
+
+        StreamReservation reservation = reserve(chunk, buffer, dstOffset + offset);
+        copyToMapped(reservation.data, bytes + offset, chunk, hostCached);
+        commit(reservation);
+
+        id = reservation.id;
+    }
+
+    return id;
+}
+
+StreamID StreamingTransfer::upload(const void* data, const Image& image, vk::ImageLayout finalLayout, vk::BufferImageCopy copy) {
+    bool hostCached = (m_engine->memory().properties().memoryTypes[m_type].propertyFlags & vk::MemoryPropertyFlags::HostCached) == vk::MemoryPropertyFlags::HostCached;
+
+    StreamReservation reservation = reserve(image, finalLayout, copy);
+    copyToMapped(reservation.data, data, reservation.size, hostCached);
+    commit(reservation);
+
+    return reservation.id;
+}
+
+void StreamingTransfer::close() {
+    m_closed.push_back(m_open);
+    m_open = NO_BATCH;
+}
+
+void StreamingTransfer::flush() {
+    if (m_open != NO_BATCH && m_batches[m_open].copies.size() > 0) {
+        close();
+    }
+
+    //submit in order, so that batches also complete in order
+    size_t submitted = 0;
+    for (; submitted < m_closed.size(); submitted++) {
+        size_t index = m_closed[submitted];
+        if (m_batches[index].uncommitted > 0) break;
+
+        submit(index);
+    }
+
+    m_closed.erase(m_closed.begin(), m_closed.begin() + submitted);
+}
+
+void StreamingTransfer::onComplete(StreamID id, std::function<void()> callback) {
+    if (complete(id)) {
+        callback();
+        return;
+    }
+
+    m_callbacks.emplace(id, std::move(callback));
+}
+
+void StreamingTransfer::update(float delta) {
+    while (retire(false));
+    flush();
+
+    //callbacks may upload more data, so they are removed before being called
+    while (m_callbacks.size() > 0 && m_callbacks.begin()->first <= m_completed) {
+        auto callback = std::move(m_callbacks.begin()->second);
+        m_callbacks.erase(m_callbacks.begin());
+        callback();
+    }
+}
+
+bool StreamingTransfer::retire(bool wait) {
+    if (m_inFlight.size() == 0) return false;
+
+    size_t index = m_inFlight.front();
+    Batch& batch = m_batches[index];
+    Renderer& renderer = m_engine->renderer();
+
+    if (wait) {
+        VkSemaphore semaphore = m_timeline->handle();
+        uint64_t value = batch.id;
+
+        VkSemaphoreWaitInfoKHR info = { VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR };
+        info.semaphoreCount = 1;
+        info.pSemaphores = &semaphore;
+        info.pValues = &value;
+
+        VkResult result = renderer.waitSemaphores()(renderer.device().handle(), &info, UINT64_MAX);
+        if (result != VK_SUCCESS) throw std::runtime_error("Could not wait on streaming batch");
+    } else {
+        uint64_t value = 0;
+        renderer.getSemaphoreCounterValue()(renderer.device().handle(), m_timeline->handle(), &value);
+        if (value < batch.id) return false;
+    }
+
+    batch.staging->reset();
+    batch.copies.clear();
+    m_completed = batch.id;
+
+    m_inFlight.pop_front();
+    m_free.push_back(index);
+    return true;
+}
+
+void StreamingTransfer::record(size_t index) {
+    Batch& batch = m_batches[index];
+    bool release = ownershipTransfer();
+    uint32_t transferFamily = release ? m_transferQueue->familyIndex() : VK_QUEUE_FAMILY_IGNORED;
+    uint32_t graphicsFamily = release ? m_graphicsQueue->familyIndex() : VK_QUEUE_FAMILY_IGNORED;
+
+    std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+    std::vector<vk::ImageMemoryBarrier> imageBarriers;
+    std::vector<vk::ImageMemoryBarrier> preBarriers;
+
+    for (auto& copy : batch.copies) {
+        if (copy.cancelled) continue;
+
+        if (copy.buffer != nullptr) {
+            vk::BufferMemoryBarrier barrier = {};
+            barrier.buffer = &copy.buffer->resource();
+            barrier.offset = copy.bufferCopy.dstOffset;
+            barrier.size = copy.bufferCopy.size;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            barrier.srcAccessMask = vk::AccessFlags::TransferWrite;
+            barrier.dstAccessMask = release ? vk::AccessFlags::None : vk::AccessFlags::MemoryRead;
+
+            bufferBarriers.push_back(barrier);
+        } else {
+            vk::ImageMemoryBarrier barrier = {};
+            barrier.image = &copy.image->resource();
+            barrier.oldLayout = vk::ImageLayout::Undefined;
+            barrier.newLayout = vk::ImageLayout::TransferDstOptimal;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstAccessMask = vk::AccessFlags::TransferWrite;
+            barrier.subresourceRange.aspectMask = copy.bufferImageCopy.imageSubresource.aspectMask;
+            barrier.subresourceRange.baseArrayLayer = copy.bufferImageCopy.imageSubresource.baseArrayLayer;
+            barrier.subresourceRange.layerCount = copy.bufferImageCopy.imageSubresource.layerCount;
+            barrier.subresourceRange.baseMipLevel = copy.bufferImageCopy.imageSubresource.mipLevel;
+            barrier.subresourceRange.levelCount = 1;
+
+            preBarriers.push_back(barrier);
+
+            barrier.oldLayout = vk::ImageLayout::TransferDstOptimal;
+            barrier.newLayout = copy.finalLayout;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            barrier.srcAccessMask = vk::AccessFlags::TransferWrite;
+            barrier.dstAccessMask = release ? vk::AccessFlags::None : vk::AccessFlags::MemoryRead;
+
+            imageBarriers.push_back(barrier);
+        }
+    }
+
+    vk::CommandBufferBeginInfo beginInfo = {};
+    beginInfo.flags = vk::CommandBufferUsageFlags::OneTimeSubmit;
+
+    vk::CommandBuffer& commandBuffer = m_transferCommands[index];
+    commandBuffer.reset({});
+    commandBuffer.begin(beginInfo);
+
+    if (preBarriers.size() > 0) {
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlags::TopOfPipe, vk::PipelineStageFlags::Transfer, {}, {}, {}, preBarriers);
+    }
+
+    for (auto& copy : batch.copies) {
+        if (copy.cancelled) continue;
+
+        if (copy.buffer != nullptr) {
+            commandBuffer.copyBuffer(batch.staging->buffer(), copy.buffer->resource(), copy.bufferCopy);
+        } else {
+            commandBuffer.copyBufferToImage(batch.staging->buffer(), copy.image->resource(), vk::ImageLayout::TransferDstOptimal, copy.bufferImageCopy);
+        }
+    }
+
+    //release barriers, or plain visibility barriers if both queues are in the same family
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlags::Transfer, release ? vk::PipelineStageFlags::BottomOfPipe : vk::PipelineStageFlags::AllCommands, {}, {}, bufferBarriers, imageBarriers);
+    commandBuffer.end();
+
+    //the copies are synchronized by the batch's timeline value, so the FrameGraph sees the resources as idle and owned by the graphics queue
+    ResourceStateTracker& tracker = m_engine->frameGraph().resourceStates();
+
+    for (auto& copy : batch.copies) {
+        if (copy.cancelled) continue;
+
+        if (copy.buffer != nullptr) {
+            tracker.reset(copy.buffer->resource(), m_graphicsQueue->familyIndex());
+        } else {
+            vk::ImageSubresourceRange range = {};
+            range.aspectMask = copy.bufferImageCopy.imageSubresource.aspectMask;
+            range.baseArrayLayer = copy.bufferImageCopy.imageSubresource.baseArrayLayer;
+            range.layerCount = copy.bufferImageCopy.imageSubresource.layerCount;
+            range.baseMipLevel = copy.bufferImageCopy.imageSubresource.mipLevel;
+            range.levelCount = 1;
+
+            tracker.reset(copy.image->resource(), range, copy.finalLayout, m_graphicsQueue->familyIndex());
+        }
+    }
+
+    if (!release) return;
+
+    for (auto& barrier : bufferBarriers) {
+        barrier.srcAccessMask = vk::AccessFlags::None;
+        barrier.dstAccessMask = vk::AccessFlags::MemoryRead;
+    }
+
+    for (auto& barrier : imageBarriers) {
+        barrier.srcAccessMask = vk::AccessFlags::None;
+        barrier.dstAccessMask = vk::AccessFlags::MemoryRead;
+    }
+
+    vk::CommandBuffer& acquire = m_acquireCommands[index];
+    acquire.reset({});
+    acquire.begin(beginInfo);
+    acquire.pipelineBarrier(vk::PipelineStageFlags::TopOfPipe, vk::PipelineStageFlags::AllCommands, {}, {}, bufferBarriers, imageBarriers);
+    acquire.end();
+}
+
+void StreamingTransfer::submit(size_t index) {
+    //batches are submitted in id order, so the signaled values only increase
+    uint64_t value = m_batches[index].id;
+    record(index);
+
+    VkTimelineSemaphoreSubmitInfoKHR timelineInfo = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR };
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &value;
+
+    vk::SubmitInfo info = {};
+    info.commandBuffers = { m_transferCommands[index] };
+    info.next = &timelineInfo;
+
+    if (ownershipTransfer()) {
+        //the acquire signals a separate timeline, a transfer submit could otherwise signal a later value before it runs
+        info.signalSemaphores = { *m_copied };
+        m_transferQueue->submit({ info }, nullptr);
+
+        VkTimelineSemaphoreSubmitInfoKHR acquireTimelineInfo = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR };
+        acquireTimelineInfo.waitSemaphoreValueCount = 1;
+        acquireTimelineInfo.pWaitSemaphoreValues = &value;
+        acquireTimelineInfo.signalSemaphoreValueCount = 1;
+        acquireTimelineInfo.pSignalSemaphoreValues = &value;
+
+        vk::SubmitInfo acquireInfo = {};
+        acquireInfo.waitSemaphores = { *m_copied };
+        acquireInfo.waitDstStageMask = { vk::PipelineStageFlags::AllCommands };
+        acquireInfo.commandBuffers = { m_acquireCommands[index] };
+        acquireInfo.signalSemaphores = { *m_timeline };
+        acquireInfo.next = &acquireTimelineInfo;
+        m_graphicsQueue->submit({ acquireInfo }, nullptr);
+    } else {
+        info.signalSemaphores = { *m_timeline };
+        m_transferQueue->submit({ info }, nullptr);
+    }
+
+    m_inFlight.push_back(index);
+}
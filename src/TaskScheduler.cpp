@@ -0,0 +1,139 @@
+#include "NovaEngine/TaskScheduler.h"
+#include "NovaEngine/Engine.h"
+
+using namespace Nova;
+
+std::coroutine_handle<> Task::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+    promise_type& promise = handle.promise();
+
+    if (promise.continuation) {
+        return promise.continuation;
+    }
+
+    //spawned tasks are destroyed by the scheduler, after the coroutine has fully suspended
+    if (promise.scheduler != nullptr) {
+        promise.scheduler->m_finished.push_back(handle);
+    }
+
+    return std::noop_coroutine();
+}
+
+Task& Task::operator = (Task&& other) noexcept {
+    if (this != &other) {
+        if (m_handle) m_handle.destroy();
+        m_handle = std::exchange(other.m_handle, nullptr);
+    }
+
+    return *this;
+}
+
+Task::~Task() {
+    if (m_handle) m_handle.destroy();
+}
+
+bool TaskScheduler::FrameComplete::await_ready() {
+    return scheduler->m_engine->frameGraph().completedFrames() > frame;
+}
+
+void TaskScheduler::StreamComplete::await_suspend(std::coroutine_handle<> handle) {
+    waiter = std::make_shared<Waiter>(Waiter{ scheduler, handle });
+    stream->onComplete(id, [weak = std::weak_ptr<Waiter>(waiter)] { wake(weak); });
+}
+
+void TaskScheduler::UploadComplete::await_suspend(std::coroutine_handle<> handle) {
+    waiter = std::make_shared<Waiter>(Waiter{ scheduler, handle });
+    uploads->onComplete(id, [weak = std::weak_ptr<Waiter>(waiter)] { wake(weak); });
+}
+
+void TaskScheduler::ReadComplete::await_suspend(std::coroutine_handle<> handle) {
+    waiter = std::make_shared<Waiter>(Waiter{ scheduler, handle });
+
+    //the awaiter lives in the suspended coroutine frame, so the result can be written into it while the waiter is alive
+    issue([this, weak = std::weak_ptr<Waiter>(waiter)](const ReadResult& result) {
+        if (weak.expired()) return;
+
+        this->result = result;
+        wake(weak);
+    });
+}
+
+void TaskScheduler::wake(const std::weak_ptr<Waiter>& waiter) {
+    std::shared_ptr<Waiter> ptr = waiter.lock();
+    if (ptr == nullptr) return;
+
+    ptr->scheduler->m_ready.push_back(ptr->handle);
+}
+
+TaskScheduler::TaskScheduler(Engine& engine) {
+    m_engine = &engine;
+}
+
+TaskScheduler::~TaskScheduler() {
+    //destroying the spawned frames also destroys any Tasks they are awaiting, and the awaiters' Waiters with them
+    for (auto address : m_tasks) {
+        std::coroutine_handle<>::from_address(address).destroy();
+    }
+}
+
+void TaskScheduler::spawn(Task task) {
+    auto handle = task.release();
+    if (!handle) return;
+
+    handle.promise().scheduler = this;
+    m_tasks.insert(handle.address());
+
+    handle.resume();
+    collect();
+}
+
+TaskScheduler::ReadComplete TaskScheduler::read(AssetIO& io, ReadPriority priority, FileID file, uint64_t offset, size_t size, void* dest) {
+    return { this, [&io, priority, file, offset, size, dest](ReadCallback callback) {
+        io.read(priority, file, offset, size, dest, std::move(callback));
+    } };
+}
+
+TaskScheduler::ReadComplete TaskScheduler::read(AssetIO& io, ReadPriority priority, FileID file, uint64_t offset, size_t size, StreamingTransfer& stream, const Buffer& buffer, size_t dstOffset) {
+    return { this, [&io, priority, file, offset, size, &stream, &buffer, dstOffset](ReadCallback callback) {
+        io.read(priority, file, offset, size, stream, buffer, dstOffset, std::move(callback));
+    } };
+}
+
+TaskScheduler::ReadComplete TaskScheduler::read(AssetIO& io, ReadPriority priority, FileID file, uint64_t offset, StreamingTransfer& stream, const Image& image, vk::ImageLayout finalLayout, vk::BufferImageCopy copy) {
+    return { this, [&io, priority, file, offset, &stream, &image, finalLayout, copy](ReadCallback callback) {
+        io.read(priority, file, offset, stream, image, finalLayout, copy, std::move(callback));
+    } };
+}
+
+void TaskScheduler::update() {
+    size_t completed = m_engine->frameGraph().completedFrames();
+
+    while (m_frames.size() > 0 && m_frames.top().frame < completed) {
+        m_ready.push_back(m_frames.top().handle);
+        m_frames.pop();
+    }
+
+    //tasks that suspend again while resuming are picked up next frame
+    std::vector<std::coroutine_handle<>> ready;
+    ready.swap(m_ready);
+
+    for (auto handle : ready) {
+        handle.resume();
+    }
+
+    collect();
+}
+
+void TaskScheduler::collect() {
+    std::exception_ptr exception;
+
+    for (auto handle : m_finished) {
+        if (!exception) exception = handle.promise().exception;
+
+        m_tasks.erase(handle.address());
+        handle.destroy();
+    }
+
+    m_finished.clear();
+
+    if (exception) std::rethrow_exception(exception);
+}
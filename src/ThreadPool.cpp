@@ -0,0 +1,106 @@
+#include "NovaEngine/ThreadPool.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <exception>
+
+using namespace Nova;
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    for (size_t i = 0; i < threadCount; i++) {
+        m_threads.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_condition.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.emplace_back(std::move(job));
+    }
+
+    m_condition.notify_one();
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> job;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stop || m_jobs.size() > 0; });
+            if (m_stop && m_jobs.size() == 0) return;
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        job();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& function) {
+    if (count == 0) return;
+
+    //helpers may still be queued after the loop is finished, so they hold shared ownership of the state
+    struct State {
+        std::function<void(size_t)> function;
+        size_t count;
+        std::atomic<size_t> next;
+        std::atomic<size_t> done;
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::exception_ptr error;
+    };
+
+    auto state = std::make_shared<State>();
+    state->function = function;
+    state->count = count;
+    state->next = 0;
+    state->done = 0;
+
+    //each helper pulls indices until none are left, so uneven jobs balance out
+    auto run = [state] {
+        size_t finished = 0;
+
+        for (size_t i = state->next++; i < state->count; i = state->next++) {
+            try {
+                state->function(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->error) state->error = std::current_exception();
+            }
+            finished++;
+        }
+
+        if (finished > 0 && state->done.fetch_add(finished) + finished == state->count) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->condition.notify_all();
+        }
+    };
+
+    size_t helpers = std::min(m_threads.size(), count - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        enqueue(run);
+    }
+
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&state] { return state->done == state->count; });
+
+    //rethrow on the calling thread, since an exception escaping a worker would terminate the process
+    if (state->error) std::rethrow_exception(state->error);
+}
\ No newline at end of file
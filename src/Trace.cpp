@@ -0,0 +1,135 @@
+#include "NovaEngine/Trace.h"
+#include "NovaEngine/GpuProfiler.h"
+#include <mutex>
+#include <chrono>
+#include <iomanip>
+#include <algorithm>
+
+using namespace Nova;
+
+//buffers are never freed, so the events of threads that exited can still be written
+struct Trace::Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+};
+
+Trace::Registry& Trace::registry() {
+    static Registry registry;
+    return registry;
+}
+
+Trace::Buffer& Trace::buffer() {
+    thread_local Buffer* buffer = nullptr;
+
+    if (buffer == nullptr) {
+        Registry& registry = Trace::registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        auto& ptr = registry.buffers.emplace_back(std::make_unique<Buffer>());
+        ptr->events.resize(Capacity);
+        ptr->thread = registry.buffers.size() - 1;
+        buffer = ptr.get();
+    }
+
+    return *buffer;
+}
+
+uint64_t Trace::now() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+void Trace::zone(const char* name, uint64_t start, uint64_t end) {
+    Buffer& buffer = Trace::buffer();
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % Capacity] = { name, start, end };
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Trace::frame(size_t frame) {
+    Buffer& buffer = Trace::buffer();
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % Capacity] = { nullptr, now(), frame };
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Trace::writeTime(std::ostream& stream, uint64_t nanoseconds) {
+    stream << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000 << std::setfill(' ');
+}
+
+void Trace::writeString(std::ostream& stream, const std::string& string) {
+    stream << '"';
+
+    for (char c : string) {
+        if (c == '"' || c == '\\') {
+            stream << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            stream << "\\u00" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+        } else {
+            stream << c;
+        }
+    }
+
+    stream << '"';
+}
+
+void Trace::write(std::ostream& stream, const GpuProfiler* profiler) {
+    stream << "{\"traceEvents\":[";
+    writeEvents(stream);
+
+    if (profiler != nullptr) {
+        stream << ",";
+        profiler->writeEvents(stream);
+    }
+
+    stream << "]}";
+}
+
+void Trace::writeEvents(std::ostream& stream, uint64_t since) {
+    Registry& registry = Trace::registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}}";
+
+    std::vector<Event> events;
+
+    for (auto& buffer : registry.buffers) {
+        stream << ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->thread;
+        stream << ",\"args\":{\"name\":\"Thread " << buffer->thread << "\"}}";
+
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t first = head > Capacity ? head - Capacity : 0;
+
+        events.clear();
+        for (uint64_t i = first; i < head; i++) {
+            events.push_back(buffer->events[i % Capacity]);
+        }
+
+        //the thread keeps recording while this copies, events it overwrote in the meantime are dropped
+        //the slot of event after may already be in the middle of being written, so it counts as overwritten too
+        uint64_t after = buffer->head.load(std::memory_order_acquire);
+        uint64_t valid = after + 1 > Capacity ? after + 1 - Capacity : 0;
+        size_t skip = static_cast<size_t>(std::min(std::max(valid, first) - first, head - first));
+
+        for (size_t i = skip; i < events.size(); i++) {
+            Event& event = events[i];
+
+            if (event.name == nullptr) {
+                if (event.start < since) continue;
+
+                stream << ",{\"name\":\"Frame " << event.end << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":" << buffer->thread << ",\"ts\":";
+                writeTime(stream, event.start);
+                stream << "}";
+            } else {
+                if (event.end < since) continue;
+
+                //zone names are string literals, they are not escaped
+                stream << ",{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->thread << ",\"ts\":";
+                writeTime(stream, event.start);
+                stream << ",\"dur\":";
+                writeTime(stream, event.end - event.start);
+                stream << "}";
+            }
+        }
+    }
+}
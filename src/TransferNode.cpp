@@ -1,5 +1,9 @@
 #include "NovaEngine/TransferNode.h"
 #include "NovaEngine/Engine.h"
+#include "NovaEngine/MemoryCopy.h"
+#include "NovaEngine/Compression.h"
+#include "NovaEngine/Trace.h"
+#include <algorithm>
 
 using namespace Nova;
 
@@ -47,7 +51,7 @@ void TransferNode::resize(size_t frames) {
     if (frames == m_allocators.size()) {
         return;
     } else if (frames < m_allocators.size()) {
-        m_allocators.erase(m_allocators.begin() + frames);
+        m_allocators.erase(m_allocators.begin() + frames, m_allocators.end());
     } else {
         for (size_t i = m_allocators.size(); i < frames; i++) {
             m_allocators.emplace_back(*m_engine, m_pageSize, m_type);
@@ -55,9 +59,46 @@ void TransferNode::resize(size_t frames) {
     }
 }
 
+void TransferNode::addMirror(MirroredBuffer& mirror) {
+    m_mirrors.push_back(&mirror);
+}
+
+void TransferNode::removeMirror(MirroredBuffer& mirror) {
+    m_mirrors.erase(std::remove(m_mirrors.begin(), m_mirrors.end(), &mirror), m_mirrors.end());
+}
+
+void TransferNode::preSubmit(size_t frame) {
+    for (auto mirror : m_mirrors) {
+        mirror->flush(*this);
+    }
+
+    m_mirrors.clear();
+}
+
+void TransferNode::planResources(ResourceStateTracker& tracker) {
+    m_layoutBarriers.clear();
+
+    //the node's ImageUsage already transitions images to TransferDstOptimal, other layouts need one more transition
+    //recorded as a second batch after the node's barriers, since both can transition the same subresources
+    for (auto& transfer : m_transfers) {
+        if (transfer.image == nullptr || transfer.imageLayout == vk::ImageLayout::TransferDstOptimal) continue;
+
+        const vk::ImageSubresourceLayers& subresource = transfer.bufferImageCopy.imageSubresource;
+
+        vk::ImageSubresourceRange range = {};
+        range.aspectMask = subresource.aspectMask;
+        range.baseArrayLayer = subresource.baseArrayLayer;
+        range.layerCount = subresource.layerCount;
+        range.baseMipLevel = transfer.generateMipmaps ? 0 : subresource.mipLevel;
+        range.levelCount = transfer.generateMipmaps ? transfer.image->resource().mipLevels() : 1;
+
+        ResourceAccess access = { vk::PipelineStageFlags::Transfer, vk::AccessFlags::TransferWrite, transfer.imageLayout, queue().familyIndex() };
+        tracker.use(transfer.image->resource(), range, access, m_layoutBarriers.images);
+    }
+}
+
 std::vector<const vk::CommandBuffer*>& TransferNode::submit(size_t frame, size_t index) {
     m_commandBuffers.clear();
-    StagingAllocator& allocator = m_allocators[index];
 
     vk::CommandBuffer& commandBuffer = commandBuffers()[index];
     commandBuffer.reset({});
@@ -68,29 +109,20 @@ std::vector<const vk::CommandBuffer*>& TransferNode::submit(size_t frame, size_t
     commandBuffer.begin(beginInfo);
 
     FrameNode::preRecord(commandBuffer);
+    m_layoutBarriers.record(commandBuffer, m_engine->renderer());
 
+    //transfers queued while the node was skipped stay in the staging memory of the frame they were queued in
     for (auto& transfer : m_transfers) {
+        StagingAllocator& allocator = m_allocators[transfer.allocator];
+
         if (transfer.buffer != nullptr) {
             commandBuffer.copyBuffer(allocator.buffer(), transfer.buffer->resource(), transfer.bufferCopy);
         } else if (transfer.image != nullptr) {
-            vk::ImageSubresourceRange range = {};
-
-            vk::ImageMemoryBarrier barrier = {};
-            barrier.image = &transfer.image->resource();
-            barrier.oldLayout = vk::ImageLayout::Undefined;
-            barrier.newLayout = transfer.imageLayout;
-            barrier.srcAccessMask = {};
-            barrier.dstAccessMask = vk::AccessFlags::TransferWrite;
-            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            barrier.subresourceRange.aspectMask = transfer.bufferImageCopy.imageSubresource.aspectMask;
-            barrier.subresourceRange.baseArrayLayer = transfer.bufferImageCopy.imageSubresource.baseArrayLayer;
-            barrier.subresourceRange.layerCount = transfer.bufferImageCopy.imageSubresource.layerCount;
-            barrier.subresourceRange.baseMipLevel = transfer.bufferImageCopy.imageSubresource.mipLevel;
-            barrier.subresourceRange.levelCount = 1;
-
-            commandBuffer.pipelineBarrier(vk::PipelineStageFlags::TopOfPipe, vk::PipelineStageFlags::Transfer, {}, {}, {}, { barrier });
             commandBuffer.copyBufferToImage(allocator.buffer(), transfer.image->resource(), transfer.imageLayout, transfer.bufferImageCopy);
+
+            if (transfer.generateMipmaps) {
+                recordMipmaps(commandBuffer, transfer);
+            }
         }
     }
 
@@ -99,32 +131,177 @@ std::vector<const vk::CommandBuffer*>& TransferNode::submit(size_t frame, size_t
     commandBuffer.end();
     m_commandBuffers.push_back(&commandBuffer);
 
+    for (auto& transfer : m_transfers) {
+        m_allocators[transfer.allocator].reset();
+    }
+
+    m_allocators[index].reset();
     m_transfers.clear();
-    allocator.reset();
     return m_commandBuffers;
 }
 
 void TransferNode::transfer(const void* data, const Buffer& buffer, vk::BufferCopy copy) {
+    NOVA_TRACE_ZONE("TransferNode::transfer");
+    void* dest = reserve(copy.size, buffer, copy.dstOffset);
+
+    vk::MemoryPropertyFlags flags = buffer.page().mapping() != nullptr ? buffer.page().flags() : m_allocators[getFrame()].flags();
+    copyToMapped(dest, data, copy.size, (flags & vk::MemoryPropertyFlags::HostCached) == vk::MemoryPropertyFlags::HostCached);
+}
+
+void TransferNode::transfer(const void* data, const Image& image, vk::ImageLayout imageLayout, vk::BufferImageCopy copy) {
+    NOVA_TRACE_ZONE("TransferNode::transfer");
+    size_t texelsToCopy = copy.imageExtent.width * copy.imageExtent.height * copy.imageExtent.depth;
+    size_t size = texelsToCopy * vk::getFormatSize(image.resource().format());
+
+    void* dest = reserve(image, imageLayout, copy);
+
+    vk::MemoryPropertyFlags flags = m_allocators[getFrame()].flags();
+    copyToMapped(dest, data, size, (flags & vk::MemoryPropertyFlags::HostCached) == vk::MemoryPropertyFlags::HostCached);
+}
+
+void TransferNode::transferCompressed(const void* data, size_t size, const Buffer& buffer, size_t dstOffset) {
+    NOVA_TRACE_ZONE("TransferNode::transferCompressed");
+    size_t decompressed = decompressedSize(data, size);
+    void* dest = reserve(decompressed, buffer, dstOffset);
+
+    vk::MemoryPropertyFlags flags = buffer.page().mapping() != nullptr ? buffer.page().flags() : m_allocators[getFrame()].flags();
+    decompress(data, size, dest, decompressed, (flags & vk::MemoryPropertyFlags::HostCached) == vk::MemoryPropertyFlags::HostCached, &m_engine->threadPool());
+}
+
+void TransferNode::transferCompressed(const void* data, size_t size, const Image& image, vk::ImageLayout imageLayout, vk::BufferImageCopy copy) {
+    NOVA_TRACE_ZONE("TransferNode::transferCompressed");
+    size_t texelsToCopy = copy.imageExtent.width * copy.imageExtent.height * copy.imageExtent.depth;
+    size_t decompressed = texelsToCopy * vk::getFormatSize(image.resource().format());
+
+    if (decompressedSize(data, size) != decompressed) {
+        throw std::runtime_error("Compressed data does not match image copy size");
+    }
+
+    void* dest = reserve(image, imageLayout, copy);
+
+    vk::MemoryPropertyFlags flags = m_allocators[getFrame()].flags();
+    decompress(data, size, dest, decompressed, (flags & vk::MemoryPropertyFlags::HostCached) == vk::MemoryPropertyFlags::HostCached, &m_engine->threadPool());
+}
+
+void TransferNode::transferMipmapped(const void* data, const Image& image, vk::ImageLayout imageLayout, vk::BufferImageCopy copy) {
+    NOVA_TRACE_ZONE("TransferNode::transferMipmapped");
+    auto& physicalDevice = m_engine->renderer().device().physicalDevice();
+    auto& family = physicalDevice.queueFamilies()[queue().familyIndex()];
+    if ((family.queueFlags & vk::QueueFlags::Graphics) == vk::QueueFlags::None) {
+        throw std::runtime_error("Mipmap generation requires a graphics queue");
+    }
+
+    vk::FormatFeatureFlags blit = vk::FormatFeatureFlags::BlitSrc | vk::FormatFeatureFlags::BlitDst;
+    vk::FormatProperties properties = physicalDevice.getFormatProperties(image.resource().format());
+    if ((properties.optimalTilingFeatures & blit) != blit) {
+        throw std::runtime_error("Format does not support blitting");
+    }
+
+    //every lower level is discarded and blitted whole from mip 0, so mip 0 has to be uploaded whole
+    vk::Extent3D extent = image.resource().extent();
+    if (copy.imageOffset.x != 0 || copy.imageOffset.y != 0 || copy.imageOffset.z != 0
+        || copy.imageExtent.width != extent.width || copy.imageExtent.height != extent.height || copy.imageExtent.depth != extent.depth) {
+        throw std::runtime_error("Mipmap generation requires a copy of the whole image");
+    }
+
+    //register the whole mip chain before transfer() registers only mip 0
+    vk::ImageSubresourceRange range = {};
+    range.aspectMask = copy.imageSubresource.aspectMask;
+    range.baseArrayLayer = copy.imageSubresource.baseArrayLayer;
+    range.layerCount = copy.imageSubresource.layerCount;
+    range.baseMipLevel = 0;
+    range.levelCount = image.resource().mipLevels();
+
+    m_imageUsage->add(image, range);
+
+    copy.imageSubresource.mipLevel = 0;
+    transfer(data, image, imageLayout, copy);
+
+    Transfer& queued = m_transfers.back();
+    queued.generateMipmaps = image.resource().mipLevels() > 1;
+}
+
+void TransferNode::recordMipmaps(vk::CommandBuffer& commandBuffer, const Transfer& transfer) {
+    const vk::Image& image = transfer.image->resource();
+    const vk::ImageSubresourceLayers& subresource = transfer.bufferImageCopy.imageSubresource;
+    vk::Extent3D extent = transfer.bufferImageCopy.imageExtent;
+    uint32_t levels = image.mipLevels();
+
+    auto& physicalDevice = m_engine->renderer().device().physicalDevice();
+    vk::FormatProperties properties = physicalDevice.getFormatProperties(image.format());
+    bool linear = (properties.optimalTilingFeatures & vk::FormatFeatureFlags::SampledImageFilterLinear) != vk::FormatFeatureFlags::None;
+
+    vk::ImageMemoryBarrier source = {};
+    source.image = &image;
+    source.oldLayout = transfer.imageLayout;
+    source.newLayout = vk::ImageLayout::TransferSrcOptimal;
+    source.srcAccessMask = vk::AccessFlags::TransferWrite;
+    source.dstAccessMask = vk::AccessFlags::TransferRead;
+    source.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    source.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    source.subresourceRange.aspectMask = subresource.aspectMask;
+    source.subresourceRange.baseArrayLayer = subresource.baseArrayLayer;
+    source.subresourceRange.layerCount = subresource.layerCount;
+    source.subresourceRange.levelCount = 1;
+
+    vk::ImageMemoryBarrier dest = source;
+    dest.oldLayout = vk::ImageLayout::Undefined;
+    dest.newLayout = transfer.imageLayout;
+    dest.srcAccessMask = {};
+    dest.dstAccessMask = vk::AccessFlags::TransferWrite;
+
+    for (uint32_t i = 1; i < levels; i++) {
+        //previous level becomes the blit source, this level is discarded and becomes the destination
+        source.subresourceRange.baseMipLevel = i - 1;
+        dest.subresourceRange.baseMipLevel = i;
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlags::Transfer, vk::PipelineStageFlags::Transfer, {}, {}, {}, { source, dest });
+
+        vk::ImageBlit blit = {};
+        blit.srcSubresource = subresource;
+        blit.srcSubresource.mipLevel = i - 1;
+        blit.srcOffsets[1] = { static_cast<int32_t>(std::max(extent.width >> (i - 1), 1u)), static_cast<int32_t>(std::max(extent.height >> (i - 1), 1u)), static_cast<int32_t>(std::max(extent.depth >> (i - 1), 1u)) };
+        blit.dstSubresource = subresource;
+        blit.dstSubresource.mipLevel = i;
+        blit.dstOffsets[1] = { static_cast<int32_t>(std::max(extent.width >> i, 1u)), static_cast<int32_t>(std::max(extent.height >> i, 1u)), static_cast<int32_t>(std::max(extent.depth >> i, 1u)) };
+
+        commandBuffer.blitImage(image, vk::ImageLayout::TransferSrcOptimal, image, transfer.imageLayout, { blit }, linear ? vk::Filter::Linear : vk::Filter::Nearest);
+    }
+
+    //return every level used as a blit source to the transfer layout, so the whole chain matches the node's ImageUsage
+    vk::ImageMemoryBarrier barrier = source;
+    barrier.oldLayout = vk::ImageLayout::TransferSrcOptimal;
+    barrier.newLayout = transfer.imageLayout;
+    barrier.srcAccessMask = vk::AccessFlags::TransferRead;
+    barrier.dstAccessMask = vk::AccessFlags::TransferWrite;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = levels - 1;
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlags::Transfer, vk::PipelineStageFlags::Transfer, {}, {}, {}, { barrier });
+}
+
+void* TransferNode::reserve(size_t size, const Buffer& buffer, size_t dstOffset) {
     if (buffer.page().mapping() != nullptr) {
         //for buffers that are host-visible (eg UMA)
-        void* dest = static_cast<void*>(static_cast<char*>(buffer.page().mapping()) + buffer.offset() + copy.dstOffset);
-        memcpy(dest, data, copy.size);
-        return;
+        return static_cast<void*>(static_cast<char*>(buffer.page().mapping()) + buffer.offset() + dstOffset);
     }
 
     size_t index = getFrame();
     StagingAllocator& allocator = m_allocators[index];
-    size_t offset = allocator.stage(data, copy.size);
+    StagingRange range = allocator.reserve(size);
 
     Transfer transfer = {};
     transfer.buffer = &buffer;
-    transfer.bufferCopy = { offset, copy.dstOffset, copy.size };
+    transfer.bufferCopy = { range.offset, dstOffset, size };
+    transfer.allocator = index;
     m_transfers.push_back(transfer);
 
-    m_bufferUsage->add(*transfer.buffer, copy.dstOffset, copy.size);
+    m_bufferUsage->add(*transfer.buffer, dstOffset, size);
+
+    return range.data;
 }
 
-void TransferNode::transfer(const void* data, const Image& image, vk::ImageLayout imageLayout, vk::BufferImageCopy copy) {
+void* TransferNode::reserve(const Image& image, vk::ImageLayout imageLayout, vk::BufferImageCopy copy) {
     //can't copy directly into images, so it must go through staging
     size_t index = getFrame();
     StagingAllocator& allocator = m_allocators[index];
@@ -132,20 +309,23 @@ void TransferNode::transfer(const void* data, const Image& image, vk::ImageLayou
     size_t texelsToCopy = copy.imageExtent.width * copy.imageExtent.height * copy.imageExtent.depth;
     size_t size = texelsToCopy * vk::getFormatSize(image.resource().format());
 
-    size_t offset = allocator.stage(data, size);
+    StagingRange range = allocator.reserve(size);
 
     Transfer transfer = {};
     transfer.image = &image;
-    transfer.bufferImageCopy = { offset, 0, 0, copy.imageSubresource, copy.imageOffset, copy.imageExtent };
+    transfer.bufferImageCopy = { range.offset, 0, 0, copy.imageSubresource, copy.imageOffset, copy.imageExtent };
     transfer.imageLayout = imageLayout;
+    transfer.allocator = index;
     m_transfers.push_back(transfer);
 
-    vk::ImageSubresourceRange range = {};
-    range.aspectMask = copy.imageSubresource.aspectMask;
-    range.baseArrayLayer = copy.imageSubresource.baseArrayLayer;
-    range.layerCount = copy.imageSubresource.layerCount;
-    range.baseMipLevel = copy.imageSubresource.mipLevel;
-    range.levelCount = 1;
+    vk::ImageSubresourceRange subresource = {};
+    subresource.aspectMask = copy.imageSubresource.aspectMask;
+    subresource.baseArrayLayer = copy.imageSubresource.baseArrayLayer;
+    subresource.layerCount = copy.imageSubresource.layerCount;
+    subresource.baseMipLevel = copy.imageSubresource.mipLevel;
+    subresource.levelCount = 1;
+
+    m_imageUsage->add(*transfer.image, subresource);
 
-    m_imageUsage->add(*transfer.image, range);
+    return range.data;
 }
\ No newline at end of file
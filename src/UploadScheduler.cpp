@@ -0,0 +1,187 @@
+#include "NovaEngine/UploadScheduler.h"
+#include "NovaEngine/Engine.h"
+#include <algorithm>
+
+using namespace Nova;
+
+UploadScheduler::UploadScheduler(Engine& engine, TransferNode& transferNode, size_t frameBudget, size_t chunkSize) {
+    m_engine = &engine;
+    m_transferNode = &transferNode;
+    m_frameBudget = frameBudget;
+    m_chunkSize = chunkSize;
+}
+
+UploadID UploadScheduler::upload(UploadPriority priority, const void* data, size_t size, const Buffer& buffer, size_t dstOffset) {
+    if (priority == UploadPriority::Critical) {
+        vk::BufferCopy copy = {};
+        copy.dstOffset = dstOffset;
+        copy.size = size;
+        m_transferNode->transfer(data, buffer, copy);
+
+        UploadID id = m_nextID++;
+        m_waiting.insert(id);
+        m_inFlight.push_back({ m_engine->frameGraph().frame(), id });
+        return id;
+    }
+
+    const char* bytes = static_cast<const char*>(data);
+
+    Upload upload = {};
+    upload.data = std::vector<char>(bytes, bytes + size);
+    upload.buffer = &buffer;
+    upload.dstOffset = dstOffset;
+
+    return enqueue(priority, std::move(upload));
+}
+
+UploadID UploadScheduler::upload(UploadPriority priority, const void* data, const Image& image, vk::ImageLayout imageLayout, vk::BufferImageCopy copy) {
+    if (priority == UploadPriority::Critical) {
+        m_transferNode->transfer(data, image, imageLayout, copy);
+
+        UploadID id = m_nextID++;
+        m_waiting.insert(id);
+        m_inFlight.push_back({ m_engine->frameGraph().frame(), id });
+        return id;
+    }
+
+    size_t texels = copy.imageExtent.width * copy.imageExtent.height * copy.imageExtent.depth;
+    size_t size = texels * vk::getFormatSize(image.resource().format());
+    const char* bytes = static_cast<const char*>(data);
+
+    Upload upload = {};
+    upload.data = std::vector<char>(bytes, bytes + size);
+    upload.image = &image;
+    upload.imageLayout = imageLayout;
+    upload.bufferImageCopy = copy;
+
+    return enqueue(priority, std::move(upload));
+}
+
+UploadID UploadScheduler::enqueue(UploadPriority priority, Upload upload) {
+    UploadID id = m_nextID++;
+    upload.id = id;
+    m_waiting.insert(id);
+
+    size_t queue = static_cast<size_t>(priority) - static_cast<size_t>(UploadPriority::High);
+    m_queues[queue].emplace_back(std::move(upload));
+
+    return id;
+}
+
+bool UploadScheduler::complete(UploadID id) const {
+    return m_waiting.count(id) == 0;
+}
+
+void UploadScheduler::update(float delta) {
+    retire();
+
+    size_t budget = m_frameBudget;
+    bool first = true;
+
+    for (auto& queue : m_queues) {
+        while (queue.size() > 0) {
+            Upload& upload = queue.front();
+
+            //always allow one chunk per frame, so that a budget smaller than a single row can't stall
+            size_t sent = send(upload, first ? std::max<size_t>(budget, 1) : budget);
+            if (sent == 0) return;
+
+            first = false;
+            budget -= std::min(sent, budget);
+
+            if (upload.progress == upload.data.size()) {
+                m_inFlight.push_back({ m_engine->frameGraph().frame(), upload.id });
+                queue.pop_front();
+            }
+
+            if (budget == 0) return;
+        }
+    }
+}
+
+size_t UploadScheduler::send(Upload& upload, size_t budget) {
+    if (upload.buffer != nullptr) {
+        return sendBuffer(upload, budget);
+    } else {
+        return sendImage(upload, budget);
+    }
+}
+
+size_t UploadScheduler::sendBuffer(Upload& upload, size_t budget) {
+    size_t remaining = upload.data.size() - upload.progress;
+    size_t size = std::min({ remaining, m_chunkSize, budget });
+
+    vk::BufferCopy copy = {};
+    copy.dstOffset = upload.dstOffset + upload.progress;
+    copy.size = size;
+    m_transferNode->transfer(upload.data.data() + upload.progress, *upload.buffer, copy);
+
+    upload.progress += size;
+    return size;
+}
+
+size_t UploadScheduler::sendImage(Upload& upload, size_t budget) {
+    //split images by rows, or by slices for 3D images
+    vk::BufferImageCopy& copy = upload.bufferImageCopy;
+    size_t rowSize = copy.imageExtent.width * vk::getFormatSize(upload.image->resource().format());
+    bool slices = copy.imageExtent.depth > 1;
+    size_t unitSize = slices ? rowSize * copy.imageExtent.height : rowSize;
+
+    size_t limit = std::min(m_chunkSize, budget);
+    size_t units = limit / unitSize;
+    if (units == 0) {
+        if (budget < m_frameBudget) return 0;
+        units = 1;  //a single row larger than the budget is still sent on its own
+    }
+
+    size_t first = upload.progress / unitSize;
+    size_t total = upload.data.size() / unitSize;
+    units = std::min(units, total - first);
+
+    vk::BufferImageCopy chunk = copy;
+    if (slices) {
+        chunk.imageOffset.z += static_cast<int32_t>(first);
+        chunk.imageExtent.depth = static_cast<uint32_t>(units);
+    } else {
+        chunk.imageOffset.y += static_cast<int32_t>(first);
+        chunk.imageExtent.height = static_cast<uint32_t>(units);
+    }
+
+    m_transferNode->transfer(upload.data.data() + upload.progress, *upload.image, upload.imageLayout, chunk);
+
+    size_t size = units * unitSize;
+    upload.progress += size;
+    return size;
+}
+
+void UploadScheduler::onComplete(UploadID id, std::function<void()> callback) {
+    if (complete(id)) {
+        callback();
+        return;
+    }
+
+    m_callbacks.emplace(id, std::move(callback));
+}
+
+void UploadScheduler::retire() {
+    size_t completed = m_engine->frameGraph().completedFrames();
+    std::vector<std::function<void()>> callbacks;
+
+    while (m_inFlight.size() > 0 && m_inFlight.front().frame < completed) {
+        UploadID id = m_inFlight.front().id;
+        m_waiting.erase(id);
+        m_inFlight.pop_front();
+
+        auto range = m_callbacks.equal_range(id);
+        for (auto it = range.first; it != range.second; it++) {
+            callbacks.push_back(std::move(it->second));
+        }
+
+        m_callbacks.erase(range.first, range.second);
+    }
+
+    //called once the queues are consistent, since callbacks may start new uploads
+    for (auto& callback : callbacks) {
+        callback();
+    }
+}
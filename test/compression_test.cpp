@@ -0,0 +1,77 @@
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <functional>
+#include <NovaEngine/Compression.h>
+
+//decompress has to reject payloads whose header doesn't match their blocks instead of writing past dest
+
+#define BLOCK_SIZE 256
+#define DATA_SIZE 1000
+
+int failures = 0;
+
+void expect(const char* name, bool condition) {
+    if (!condition) {
+        std::cout << "FAILED: " << name << "\n";
+        failures++;
+    }
+}
+
+bool throws(const std::function<void()>& function) {
+    try {
+        function();
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+
+    return false;
+}
+
+std::vector<char> withHeader(std::vector<char> payload, const std::function<void(Nova::CompressedHeader&)>& edit) {
+    Nova::CompressedHeader header;
+    memcpy(&header, payload.data(), sizeof(Nova::CompressedHeader));
+    edit(header);
+    memcpy(payload.data(), &header, sizeof(Nova::CompressedHeader));
+    return payload;
+}
+
+int main() {
+    std::vector<char> data(DATA_SIZE);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<char>(i * 7);
+    }
+
+    std::vector<char> payload = Nova::compress(Nova::Codec::Stored, data.data(), data.size(), BLOCK_SIZE);
+
+    //a guard region after dest catches writes past its end
+    std::vector<char> dest(DATA_SIZE + BLOCK_SIZE, 0x55);
+    auto decompress = [&](const std::vector<char>& bytes) {
+        Nova::decompress(bytes.data(), bytes.size(), dest.data(), DATA_SIZE, true);
+    };
+    auto guardIntact = [&]() {
+        for (size_t i = DATA_SIZE; i < dest.size(); i++) {
+            if (dest[i] != 0x55) return false;
+        }
+        return true;
+    };
+
+    decompress(payload);
+    expect("valid payload round trips", memcmp(dest.data(), data.data(), DATA_SIZE) == 0);
+
+    expect("zero block size", throws([&]() { decompress(withHeader(payload, [](Nova::CompressedHeader& h) { h.blockSize = 0; })); }));
+    expect("block count too large", throws([&]() { decompress(withHeader(payload, [](Nova::CompressedHeader& h) { h.blockCount++; })); }));
+    expect("block count too small", throws([&]() { decompress(withHeader(payload, [](Nova::CompressedHeader& h) { h.blockCount--; })); }));
+    expect("size larger than dest", throws([&]() { decompress(withHeader(payload, [](Nova::CompressedHeader& h) { h.size = DATA_SIZE + 1; })); }));
+    expect("size smaller than blocks", throws([&]() { decompress(withHeader(payload, [](Nova::CompressedHeader& h) { h.size = BLOCK_SIZE; })); }));
+    expect("size overflows", throws([&]() { decompress(withHeader(payload, [](Nova::CompressedHeader& h) { h.size = ~uint64_t(0); })); }));
+    expect("truncated payload", throws([&]() { decompress(std::vector<char>(payload.begin(), payload.end() - 1)); }));
+    expect("guard region intact", guardIntact());
+
+    if (failures == 0) {
+        std::cout << "All compression tests passed\n";
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <NovaEngine/MemoryCopy.h>
+
+//ordinary host memory stands in for mapped device memory
+//write-combined memory favors the streaming kernels even more than this shows
+
+#define BYTES_PER_SIZE (1024ull * 1024 * 1024)
+#define ALIGNMENT 64
+
+const size_t sizes[] = {
+    4 * 1024,
+    64 * 1024,
+    1024 * 1024,
+    2 * 1024 * 1024,
+    4 * 1024 * 1024,
+    16 * 1024 * 1024,
+    64 * 1024 * 1024
+};
+
+const Nova::CopyKernel kernels[] = {
+    Nova::CopyKernel::Memcpy,
+    Nova::CopyKernel::SSE2Stream,
+    Nova::CopyKernel::AVX2Stream
+};
+
+std::string sizeName(size_t size) {
+    if (size >= 1024 * 1024) return std::to_string(size / (1024 * 1024)) + " MiB";
+    return std::to_string(size / 1024) + " KiB";
+}
+
+double measure(Nova::CopyKernel kernel, char* dest, const char* src, size_t size) {
+    size_t iterations = std::max<size_t>(BYTES_PER_SIZE / size, 4);
+
+    //warm up
+    Nova::copyMemory(dest, src, size, kernel);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        Nova::copyMemory(dest, src, size, kernel);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return (static_cast<double>(size) * iterations) / seconds / 1e9;
+}
+
+int main() {
+    size_t maxSize = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+    std::vector<char> srcStorage(maxSize + ALIGNMENT);
+    std::vector<char> destStorage(maxSize + ALIGNMENT);
+
+    char* src = srcStorage.data();
+    char* dest = destStorage.data() + (ALIGNMENT - reinterpret_cast<uintptr_t>(destStorage.data()) % ALIGNMENT);
+
+    for (size_t i = 0; i < maxSize; i++) {
+        src[i] = static_cast<char>(rand());
+    }
+
+    std::cout << std::left << std::setw(12) << "size";
+    for (auto kernel : kernels) {
+        std::cout << std::setw(16) << Nova::copyKernelName(kernel);
+    }
+    std::cout << "(GB/s)\n";
+
+    for (auto size : sizes) {
+        std::cout << std::setw(12) << sizeName(size);
+
+        for (auto kernel : kernels) {
+            if (Nova::copyKernelSupported(kernel)) {
+                std::cout << std::setw(16) << std::fixed << std::setprecision(2) << measure(kernel, dest, src, size);
+            } else {
+                std::cout << std::setw(16) << "n/a";
+            }
+        }
+
+        std::cout << "\n";
+    }
+
+    return 0;
+}